@@ -24,11 +24,19 @@
 void Load_Cartridge(char *filename);
 
 u8 Read_Cartridge_Prg(u16 address);
-u8 Read_Cartridge_Chr(u16 address);
 
 u8 Write_Cartridge_Prg(u16 address, u8 value);
 u8 Write_Cartridge_Chr(u16 address, u8 value);
 
+void Sync_Cartridge_Ram(u8 wait);
+
+/* Room for the state of any board (see Save_Cartridge_State): 8K each
+ * of PRG and CHR RAM, and the registers */
+#define CART_STATE_SIZE (17 * 1024)
+
+void Save_Cartridge_State(u8 *state);
+void Load_Cartridge_State(const u8 *state);
+
 void Unload_Cartridge(void);
 
 #endif /* #ifndef VNES_CART_H */
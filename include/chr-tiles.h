@@ -0,0 +1,39 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: chr-tiles.h
+ *
+ * Description:
+ *
+ *      Decoded pattern table tiles.  A tile is 16 bytes of CHR, two
+ *      bit planes of eight rows; the renderer wants one 2-bit palette
+ *      index per pixel, so every tile is kept decoded next to the CHR
+ *      it came from, along with a horizontally flipped copy for
+ *      sprites.  CHR ROM is decoded once when it is loaded, and CHR RAM
+ *      a row at a time as it is written.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#ifndef VNES_CHR_TILES_H
+#define VNES_CHR_TILES_H
+
+#include "types.h"
+
+#define CHR_TILE_BYTES  16      /* Size of a tile in CHR */
+
+typedef struct chr_tile {
+    u8 pixel[8][8];     /* Palette index (0-3) of each pixel, by row */
+    u8 flipped[8][8];   /* The same, mirrored left to right */
+} chr_tile;
+
+/* Decodes count tiles of CHR into tiles */
+void Decode_Chr_Tiles(chr_tile *tiles, const u8 *chr, u32 count);
+
+/* Decodes one row (0-7) of a tile again, after a write to its CHR */
+void Decode_Chr_Row(chr_tile *tile, const u8 *chr, u8 row);
+
+#endif /* #ifndef VNES_CHR_TILES_H */
@@ -0,0 +1,168 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: cpu-aot.h
+ *
+ * Description:
+ *
+ *      Interface between the core and PRG ROM that was translated to C
+ *      ahead of time by the recomp tool.  recomp emits one function per
+ *      reachable block plus an aot_module describing them; built as a
+ *      shared object, the module is loaded with Cpu_Load_Aot and its
+ *      functions are used as the native code of matching decoded
+ *      blocks (see Aot_Find).
+ *
+ *      Translated blocks follow the same contract as cpu-jit.c: they
+ *      return the cycles they ran and the caller adds them, and they
+ *      are never run across the next scheduled event.  Unlike the
+ *      JIT they do access I/O themselves, after first handing the
+ *      cycles run so far to Cpu_Add_Cycles, so that the PPU sees every
+ *      access at the same cycle the interpreter would make it.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#ifndef VNES_CPU_AOT_H
+#define VNES_CPU_AOT_H
+
+#include "types.h"
+#include "cpu.h"
+#include "cpu-block.h"
+
+/* Bumped whenever aot_host, aot_block, aot_module or cpu_6502 change */
+#define AOT_VERSION     3
+
+/* Name of the aot_module a translated module exports */
+#define AOT_SYMBOL      "vnes_aot"
+
+/* Hash of the bytes a block was translated from (FNV-1a) */
+#define AOT_HASH_INIT   2166136261u
+#define AOT_HASH_STEP(hash, byte) (((hash) ^ (byte)) * 16777619u)
+
+/* What translated code gets from the emulator */
+typedef struct aot_host {
+    cpu_6502 *cpu;
+    u8 *ram;                                /* Internal RAM */
+    const u8 *code_map;                     /* Mem_Get_Code_Map() */
+    u8 (*read)(u16 address);                /* Mem_Fetch */
+    void (*write)(u16 address, u8 value);   /* Mem_Set */
+    void (*add_cycles)(u32 cycles);         /* Cpu_Add_Cycles */
+    void (*invalidate)(u16 offset);         /* Cpu_Invalidate_Code */
+} aot_host;
+
+typedef struct aot_block {
+    u16 pc;                 /* PRG address the block starts at */
+    u8 bytes;               /* Number of bytes it was translated from */
+    u32 hash;               /* and their hash */
+    native_block run;
+} aot_block;
+
+typedef struct aot_module {
+    u32 version;            /* AOT_VERSION */
+    void (*bind)(const aot_host *host);
+    u32 count;
+    const aot_block *blocks;
+} aot_module;
+
+#ifdef USE_AOT
+/* Native code for blk from the loaded module, if there is any and it
+ * was translated from the same bytes. */
+native_block Aot_Find(const decoded_block *blk);
+#endif /* #ifdef USE_AOT */
+
+#ifdef AOT_MODULE
+/* Building blocks of translated code.  Each block function starts with
+ * AOT_ENTER and leaves through AOT_LEAVE; cyc counts the cycles that
+ * haven't been handed to the host yet. */
+static const aot_host *host;
+
+static void Aot_Bind(const aot_host *h) {
+    host = h;
+}
+
+/* ram and code are locals so that stores through them don't make the
+ * compiler load them again */
+#define AOT_ENTER()                                                    \
+    cpu_6502 *const cpu = host->cpu;                                   \
+    u8 *const ram = host->ram;                                         \
+    const u8 *const code = host->code_map;                             \
+    register u8 a = cpu->a, x = cpu->x, y = cpu->y;                    \
+    register u8 s = cpu->s, p = cpu->p;                                \
+    register u16 ad;                                                   \
+    register u8 v, t;                                                  \
+    register u32 cyc = 0;                                              \
+    (void)ram; (void)code; (void)ad; (void)v; (void)t
+
+#define AOT_SYNC()                                                     \
+    (cpu->a = a, cpu->x = x, cpu->y = y, cpu->s = s, cpu->p = p)
+
+#define AOT_LEAVE(pc_)                                                 \
+    do { AOT_SYNC(); cpu->pc = (pc_); return cyc; } while (0)
+
+/* Hand the cycles so far to the PPU before an I/O access */
+#define AOT_FLUSH()                                                    \
+    (host->add_cycles(cyc), cyc = 0, AOT_SYNC())
+
+#define IS_CODE(o) (code[(o) >> 3] & (1 << ((o) & 7)))
+
+/* Internal RAM.  Writes to decoded code invalidate it and leave (with
+ * the instruction's n cycles counted) at next. */
+#define RAM_RD(ad_)          ram[(ad_) & 0x07FF]
+#define RAM_WR(ad_, v_, next, n)                                       \
+    do {                                                               \
+        ad = (ad_) & 0x07FF;                                           \
+        ram[ad] = (v_);                                          \
+        if (IS_CODE(ad)) {                                             \
+            host->invalidate(ad); cyc += (n); AOT_LEAVE(next);         \
+        }                                                              \
+    } while (0)
+
+/* Anything else; I/O gets the cycles so far first */
+#define ANY_RD(ad_)                                                    \
+    (((ad_) < 0x2000) ? RAM_RD(ad_) :                                  \
+     ((ad_) < 0x4020) ? (AOT_FLUSH(), host->read(ad_)) : host->read(ad_))
+#define ANY_WR(ad_, v_, next, n)                                       \
+    do {                                                               \
+        if ((ad_) < 0x2000) { RAM_WR(ad_, v_, next, n); break; }       \
+        AOT_FLUSH();                                                   \
+        host->write(ad_, v_);                                          \
+        if (cpu->pending) { cyc += (n); AOT_LEAVE(next); }       \
+    } while (0)
+
+#define PUSH(v_, next, n)    RAM_WR(0x100 | s--, v_, next, n)
+#define PULL()               ram[0x100 | ++s]
+
+/* Push that doesn't leave, for JSR, which ends the block anyway */
+#define STACK_WR(v_)                                                   \
+    do {                                                               \
+        ad = 0x100 | s--;                                              \
+        ram[ad] = (v_);                                          \
+        if (IS_CODE(ad)) host->invalidate(ad);                         \
+    } while (0)
+
+#define CROSS(base, ad_)     (((base) & 0xFF00) != ((ad_) & 0xFF00))
+
+/* Flags */
+#define NZ(v_)                                                         \
+    p = (p & ~(FLG_SIGN | FLG_ZERO)) | ((v_) & FLG_SIGN) | ((v_) ? 0 : FLG_ZERO)
+#define SET_C(c_)    p = (p & ~FLG_CARRY) | ((c_) ? FLG_CARRY : 0)
+#define SET_V(c_)    p = (p & ~FLG_OVERFLOW) | ((c_) ? FLG_OVERFLOW : 0)
+
+#define ADD(v_) {                                                      \
+    register u16 r_ = (u16)a + (u16)(v_) + (p & FLG_CARRY);            \
+    SET_V((a ^ r_) & ((v_) ^ r_) & 0x80);                              \
+    SET_C(r_ > 0xFF);                                                  \
+    a = (u8)r_; NZ(a);                                                 \
+}
+#define COMPARE(r, v_) {                                               \
+    SET_C((r) >= (v_)); t = (r) - (v_); NZ(t);                         \
+}
+#define BIT(v_)                                                        \
+    p = (p & ~(FLG_SIGN | FLG_OVERFLOW | FLG_ZERO)) |                  \
+        ((v_) & (FLG_SIGN | FLG_OVERFLOW)) | ((a & (v_)) ? 0 : FLG_ZERO)
+#endif /* #ifdef AOT_MODULE */
+
+#endif /* #ifndef VNES_CPU_AOT_H */
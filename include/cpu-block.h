@@ -0,0 +1,59 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: cpu-block.h
+ *
+ * Description:
+ *
+ *      Decoded block cache structures, shared by the threaded core
+ *      (cpu-threaded.c) and the native code generator (cpu-jit.c).
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#ifndef VNES_CPU_BLOCK_H
+#define VNES_CPU_BLOCK_H
+
+#include "types.h"
+
+#define BLOCK_MAX_OPS    16
+#define BLOCK_MAX_BYTES  (BLOCK_MAX_OPS * 3)
+
+/* Native code for a block.  Runs the block (or a prefix of it), leaves
+ * the registers and PC in cpu, and returns the cycles it took. */
+typedef u32 (*native_block)(void);
+
+/* Loops back to the start of their own block that the core can run
+ * faster than one time round after another */
+#define BLOCK_LOOP_NONE  0
+#define BLOCK_LOOP_IDLE  1      /* Polling loop (Idle_Loop) */
+#define BLOCK_LOOP_BULK  2      /* Fill or copy loop (Bulk_Loop) */
+
+typedef struct decoded_op {
+#ifdef USE_COMPUTED_GOTO
+    const void *handler;    /* Address of the handler body */
+#else
+    u16 handler;            /* Switch case of the handler body */
+#endif /* #ifdef USE_COMPUTED_GOTO */
+    u16 operand;            /* Operand bytes, little-endian */
+    u8 opcode;              /* Opcode byte */
+    u8 length;              /* Instruction length in bytes */
+} decoded_op;
+
+typedef struct decoded_block {
+    u16 pc;                 /* PC (ROM) or RAM offset the block starts at */
+    u8 count;               /* Number of decoded instructions */
+    u8 bytes;               /* Number of bytes the block was decoded from */
+    u8 loop;                /* Kind of loop to its own start (BLOCK_LOOP_*) */
+    u32 cycles;             /* Summed base cycle count */
+    u32 max_cycles;         /* Cycles including worst-case penalties */
+    u32 hits;               /* Times the block was entered */
+    native_block native;    /* Compiled code, if any */
+    const u8 *src[2];       /* Pages of its first and last byte (ROM) */
+    decoded_op ops[BLOCK_MAX_OPS];
+} decoded_block;
+
+#endif /* #ifndef VNES_CPU_BLOCK_H */
@@ -0,0 +1,43 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: cpu-jit.h
+ *
+ * Description:
+ *
+ *      Native (x86-64) code generator for hot decoded blocks.  Only
+ *      built when USE_JIT is defined and the host is x86-64.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#ifndef VNES_CPU_JIT_H
+#define VNES_CPU_JIT_H
+
+#include "types.h"
+#include "cpu-block.h"
+
+#if defined(USE_JIT) && !defined(__x86_64__)
+#undef USE_JIT
+#endif
+
+/* Entries into a block before it gets compiled */
+#ifndef JIT_HOT_THRESHOLD
+#define JIT_HOT_THRESHOLD 32
+#endif
+
+#ifdef USE_JIT
+/* Compiles a PRG ROM block.  Returns 0 if the block can't be compiled
+ * (its first instruction isn't supported, or the code buffer is full);
+ * the interpreter keeps running it in that case. */
+native_block Jit_Compile(const decoded_block *blk);
+
+/* Throws away all compiled code.  Called whenever the block cache is
+ * flushed. */
+void Jit_Reset(void);
+#endif /* #ifdef USE_JIT */
+
+#endif /* #ifndef VNES_CPU_JIT_H */
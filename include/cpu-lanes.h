@@ -0,0 +1,96 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: cpu-lanes.h
+ *
+ * Description:
+ *
+ *      Lockstep CPU core for running many copies of the same ROM at
+ *      once (batch evaluation with different inputs).  Registers and
+ *      internal RAM of CPU_LANES instances are kept struct-of-arrays,
+ *      so that one instruction is executed for every lane at the same
+ *      PC by loops over the lanes, written for the compiler to turn
+ *      into SIMD code.  Lanes at other PCs run in smaller groups (one
+ *      lane at the worst), always starting with the lane furthest
+ *      behind, so that they tend to fall back into step.
+ *
+ *      Experimental: it is checked against the scalar core, but has
+ *      not been shown to be faster than running that once per instance.
+ *      So far it is as fast at best, and slower on real code; lanecheck
+ *      prints both times.
+ *
+ *      Each lane is a whole NES: besides the CPU and internal RAM it
+ *      keeps its own PPU, cartridge state (mapper registers, PRG and
+ *      CHR RAM) and pending interrupts, while the PRG ROM is shared
+ *      and read through the lane's own bank windows.  Lockstep steps
+ *      only reach internal RAM and PRG ROM; a lane stops in front of
+ *      any other access (PPU, APU, joypads, cartridge RAM or mapper
+ *      writes), and once it reaches its next event (vblank, or a
+ *      mapper IRQ), so that the caller can swap it into the scalar
+ *      emulator (Lanes_Load), let that run the access or the event,
+ *      and take it back (Lanes_Store).  Only built when USE_LANES is
+ *      defined; lanecheck (make lanecheck) runs a ROM this way and
+ *      checks every lane against a run of the scalar core.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#ifndef VNES_CPU_LANES_H
+#define VNES_CPU_LANES_H
+
+#include "types.h"
+#include "cart.h"
+#include "ppu.h"
+
+#ifndef CPU_LANES
+#define CPU_LANES       16
+#endif
+
+#define LANE_RAM_SIZE   0x800
+#define LANE_ROM_PAGES  0x80    /* Pages of $8000-$FFFF */
+
+/* Lane states */
+#define LANE_RUNNING    0
+#define LANE_STOPPED    1   /* In front of an access it can't make, or at
+                             * its next event */
+#define LANE_IDLE       2   /* Left out of Lanes_Exec by the caller */
+
+/* A few hundred K, so not for the stack */
+typedef struct cpu_lanes {
+    u8 a[CPU_LANES];
+    u8 x[CPU_LANES];
+    u8 y[CPU_LANES];
+    u8 p[CPU_LANES];
+    u8 s[CPU_LANES];
+    u8 state[CPU_LANES];
+    u8 pending[CPU_LANES];  /* cpu.pending */
+    u8 irq[CPU_LANES];      /* cpu.irq */
+    u16 pc[CPU_LANES];
+    u64 cycles[CPU_LANES];
+    u64 next[CPU_LANES];    /* Cycle count the lane stops at */
+    u8 ram[LANE_RAM_SIZE][CPU_LANES];   /* Byte i of lane l at [i][l] */
+    const u8 *rom[LANE_ROM_PAGES][CPU_LANES];   /* mem_read_map, or 0 */
+
+    /* The rest of each machine, only touched by Lanes_Load/Store */
+    ppu_2c02 ppu[CPU_LANES];
+    u8 cart[CPU_LANES][CART_STATE_SIZE];
+} cpu_lanes;
+
+#ifdef USE_LANES
+/* Copies the scalar emulator into every lane */
+void Lanes_Init(cpu_lanes *lanes);
+
+/* Moves a lane into the scalar emulator (CPU, internal RAM, PPU and
+ * cartridge), and back */
+void Lanes_Load(const cpu_lanes *lanes, u8 lane);
+void Lanes_Store(cpu_lanes *lanes, u8 lane);
+
+/* Runs every running lane for at least the given number of cycles,
+ * or until it stops.  Returns a bit mask of the lanes that stopped. */
+u32 Lanes_Exec(cpu_lanes *lanes, u32 cycles);
+#endif /* #ifdef USE_LANES */
+
+#endif /* #ifndef VNES_CPU_LANES_H */
@@ -20,6 +20,8 @@
 #define VNES_CPU_H
 
 #include "types.h"
+#include "mem.h"
+#include "sched.h"
 
 #define FLG_SIGN        0x80
 #define FLG_OVERFLOW    0x40
@@ -30,6 +32,19 @@
 #define FLG_ZERO        0x02
 #define FLG_CARRY       0x01
 
+/* Pending events, serviced between instructions */
+#define CPU_PENDING_NMI         0x01
+#define CPU_PENDING_BLOCK_EXIT  0x02
+#define CPU_PENDING_IRQ         0x04
+#define CPU_PENDING_STALL       0x08
+
+/* IRQ sources, held in cpu.irq until acknowledged */
+#define CPU_IRQ_MAPPER          0x01
+
+/* Cycles run by the threaded core between checks of cpu.state (about
+ * one scanline's worth) */
+#define CPU_RUN_SLICE   114
+
 typedef struct cpu_6502 {    
     u8 a;       /* Accumulator      */
     u8 x;       /* X Index Register */
@@ -39,22 +54,74 @@ typedef struct cpu_6502 {
     u16 pc;     /* Program Counter  */
 
     u8 state;   /* VNES CPU State   */
-    u32 cycles; /* Total number of cycles */    
+    u8 pending; /* Pending events (CPU_PENDING_*) */
+    u8 irq;     /* Sources holding the IRQ line low (CPU_IRQ_*) */
+    u16 stall;  /* Cycles to halt for at the next boundary (Cpu_Stall) */
+    u64 cycles; /* Total number of cycles (the timeline, see sched.h) */
 } cpu_6502;
 
+/* Instance of the cpu (cpu.c) */
+extern cpu_6502 cpu;
+
+/* Memory of the page code is being fetched from (see Cpu_Fetch), and
+ * the page's address */
+extern const u8 *cpu_fetch_page;
+extern u16 cpu_fetch_base;
+
 /* Initialization Functions */
-INLINED void Cpu_Init(void);
-INLINED void Cpu_Reset(void);
+void Cpu_Init(void);
+void Cpu_Reset(void);
+
+/* Func: u8 Cpu_Fetch(void)
+ * Desc: Fetches the next byte from memory. */
+static inline u8 Cpu_Fetch(void) {
+    if (!cpu_fetch_page || PAGE_OF(cpu.pc) != cpu_fetch_base) {
+        cpu_fetch_base = PAGE_OF(cpu.pc);
+        cpu_fetch_page = Mem_Get_Page(cpu.pc);
+        if (!cpu_fetch_page) return Mem_Fetch(cpu.pc++);
+    }
+    return cpu_fetch_page[cpu.pc++ & 0xFF];
+}
+
+void Cpu_Flush_Fetch(void);
+
+/* Func: void Cpu_Add_Cycles(u32 cycles)
+ * Desc: Advances the timeline, firing any events that came due. */
+static inline void Cpu_Add_Cycles(u32 cycles) {
+    cpu.cycles += cycles;
+    if (cpu.cycles >= sched_next) Sched_Run(cpu.cycles);
+}
+
+static inline u64 Cpu_Get_Cycles(void) {
+    return cpu.cycles;
+}
+
+VNES_Err Cpu_Step(void);
+void Cpu_Take_Interrupts(void);
+void Cpu_Stall(u16 cycles);
+void Cpu_Run_Stall(void);
+
+/* Threaded core (cpu-threaded.c): runs whole instructions until at
+ * least the given number of cycles have elapsed. */
+u32 Cpu_Exec(u32 cycles);
+
+/* Decoded block cache maintenance (cpu-threaded.c) */
+void Cpu_Flush_Blocks(void);
+void Cpu_Invalidate_Code(u16 offset);
 
-/* Byte fetching */
-INLINED u8 Cpu_Fetch(void);
+/* Native code for hot blocks (USE_JIT, x86-64 only), off by default */
+void Cpu_Set_Jit(u8 enable);
 
-INLINED void Cpu_Add_Cycles(u32 cycles);
-INLINED u32 Cpu_Get_Cycles(void);
+/* PRG ROM translated ahead of time by recomp (USE_AOT, cpu-aot.c) */
+u8 Cpu_Load_Aot(const char *path);
 
-INLINED VNES_Err Cpu_Step(void);
+/* Prints the most executed instruction pairs (USE_PAIR_PROFILE builds
+ * only), to pick superinstructions from */
+void Cpu_Report_Pairs(u32 top);
 
-INLINED void Cpu_Nmi(void);
+void Cpu_Nmi(void);
+void Cpu_Irq(u8 source);
+void Cpu_Ack_Irq(u8 source);
 
 void Cpu_Run(void);
 
@@ -26,6 +26,9 @@ typedef struct icart icart;
 typedef u8 (*cart_read)(icart *, u16);
 typedef u8 (*cart_write)(icart *, u16, u8);
 typedef void (*cart_delete)(icart *);
+typedef void (*cart_sync)(icart *, u8);
+typedef void (*cart_save_state)(icart *, u8 *);
+typedef void (*cart_load_state)(icart *, const u8 *);
 
 /* VNES Cartridge Interface.  VNES_CART_INTERFACE must be the first part
  * of any struct that implements a mapper for a particular cartridge.
@@ -35,14 +38,25 @@ typedef void (*cart_delete)(icart *);
 #define VNES_CART_INTERFACE                                            \
     /* Cartridge type */                                               \
     u8 type;                                                           \
-    /* Read function handlers */                                       \
+    /* Read function handlers.  CHR is read through the PPU page       \
+     * table, which the cartridge keeps pointed at its CHR banks       \
+     * (Ppu_Map_Chr). */                                               \
     cart_read Read_Prg;                                                \
-    cart_read Read_Chr;                                                \
                                                                        \
     /* Write function handlers */                                      \
     cart_write Write_Prg;                                              \
     cart_write Write_Chr;                                              \
                                                                        \
+    /* Writes battery-backed RAM back to its file, waiting for it if   \
+     * the flag is set (0 without a battery) */                        \
+    cart_sync Sync_Ram;                                                \
+                                                                       \
+    /* Copy the board's state (registers, bank windows, PRG and CHR    \
+     * RAM) out to CART_STATE_SIZE bytes and back, so that runs of one \
+     * game can take turns on the cartridge (cpu-lanes.h) */           \
+    cart_save_state Save_State;                                        \
+    cart_load_state Load_State;                                        \
+                                                                       \
     /* Unload/delete function handler */                               \
     cart_delete Unload;                                                \
 
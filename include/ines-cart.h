@@ -17,6 +17,7 @@
 #define VNES_INES_CART_H
 
 #include "icart.h"
+#include "chr-tiles.h"
 
 #define CART_INES 0x01
 
@@ -24,6 +25,17 @@
 #define INES_PRG_PAGE_SIZE (16 * 1024)
 #define INES_CHR_PAGE_SIZE (8 * 1024)
 
+/* Windows the mappers switch banks into: 8K of PRG at $8000-$FFFF and
+ * 1K of CHR at $0000-$1FFF.  Larger banks take several windows. */
+#define INES_PRG_BANK_SIZE  (8 * 1024)
+#define INES_CHR_BANK_SIZE  (1 * 1024)
+#define INES_PRG_WINDOWS    4
+#define INES_CHR_WINDOWS    8
+
+/* PRG RAM at $6000-$7FFF, battery-backed by a .sav file if the header
+ * says so (see Map_iNES_Prg_Ram) */
+#define INES_PRG_RAM_SIZE   (8 * 1024)
+
 #define INES_MIRROR_MASK        0x03
 #define INES_MIRROR_VERTICAL    0x00
 #define INES_MIRROR_HORIZONTAL  0x01
@@ -42,13 +54,28 @@
     u8 **prg_rom;                                                      \
     u8 **chr_rom;                                                      \
                                                                        \
+    u8 *chr_ram;    /* 8K of CHR RAM if there are no CHR pages */      \
+    chr_tile *chr_tiles; /* CHR ROM (or RAM) decoded, tile by tile */  \
+    u8 *prg_ram;    /* 8K of PRG RAM */                                \
+    u8 prg_ram_file; /* prg_ram is the mapped .sav file */             \
+                                                                       \
     u8 flags;       /* Mirror type, trainer, save RAM, NTSC/PAL */     \
     u8 *trainer;                                                       \
+                                                                       \
+    /* What each window reads, set by Switch_iNES_Prg/Chr */           \
+    u8 *prg_bank[INES_PRG_WINDOWS];                                    \
+    u8 *chr_bank[INES_CHR_WINDOWS];                                    \
     
 typedef struct ines_cart {
     VNES_INES_CART_INTERFACE
 } ines_cart;
 
-icart *Load_iNES(FILE *fp);
+icart *Load_iNES(FILE *fp, const char *path);
+
+/* Bank switching for mappers.  Points a window at an 8K PRG or 1K CHR
+ * bank (wrapped to the size of the ROM), so that reads never do any
+ * bank arithmetic. */
+void Switch_iNES_Prg(ines_cart *cart, u8 window, u16 bank);
+void Switch_iNES_Chr(ines_cart *cart, u8 window, u16 bank);
 
 #endif /* #ifndef VNES_INES_CART_H */
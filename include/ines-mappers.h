@@ -0,0 +1,64 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: ines-mappers.h
+ *
+ * Description:
+ *
+ *      Registry of the iNES mappers (cartridge boards) VNES supports.
+ *      All of them read PRG and CHR through the bank windows of
+ *      ines_cart; a mapper only sets the windows up when the cartridge
+ *      is loaded, and repoints them when its registers are written.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#ifndef VNES_INES_MAPPERS_H
+#define VNES_INES_MAPPERS_H
+
+#include "ines-cart.h"
+
+/* Supported mappers: (iNES number, name, cartridge struct) */
+#define INES_MAPPER_LIST(m)                                            \
+    m(0, NROM,  ines_cart)                                             \
+    m(1, MMC1,  mmc1_cart)                                             \
+    m(2, UxROM, ines_cart)                                             \
+    m(3, CNROM, ines_cart)                                             \
+    m(4, MMC3,  mmc3_cart)
+
+/* MMC1 (SxROM): registers are loaded serially, one bit per write */
+typedef struct mmc1_cart {
+    VNES_INES_CART_INTERFACE
+    u8 shift;       /* Bits written so far, LSB first */
+    u8 count;       /* Number of them */
+    u8 control;     /* Mirroring, PRG and CHR bank modes */
+    u8 chr[2];      /* CHR banks (4K, or 8K from chr[0]) */
+    u8 prg;         /* PRG bank (16K) */
+} mmc1_cart;
+
+/* MMC3 (TxROM) */
+typedef struct mmc3_cart {
+    VNES_INES_CART_INTERFACE
+    u8 select;      /* Bank select ($8000): register, PRG/CHR modes */
+    u8 reg[8];      /* R0-R5 CHR banks (1K units), R6-R7 PRG (8K) */
+    u8 irq_latch;   /* $C000 */
+    u8 irq_counter; /* Scanline counter, clocked by PPU A12 rises */
+    u8 irq_reload;  /* Reload requested at $C001 */
+    u8 irq_enabled; /* $E000 disables, $E001 enables */
+} mmc3_cart;
+
+typedef struct ines_mapper {
+    u8 id;                          /* iNES mapper number */
+    const char *name;
+    u32 size;                       /* Size of its cartridge struct */
+    void (*Reset)(ines_cart *);     /* Sets up the power-on banks */
+    cart_write Write_Prg;           /* Register writes */
+} ines_mapper;
+
+/* The registry entry for an iNES mapper number, or 0 if unsupported */
+const ines_mapper *Find_iNES_Mapper(u8 id);
+
+#endif /* #ifndef VNES_INES_MAPPERS_H */
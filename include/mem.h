@@ -17,17 +17,98 @@
 #define VNES_MEM_H
 
 #include "types.h"
+#include "bitwise.h"
 
-INLINED void Mem_Init(void);
-INLINED void Mem_Reset(void);
+#define INTERNAL_MEM_SIZE 0x800
 
-INLINED u8 Mem_Fetch(u16 address);
-INLINED u16 Mem_Fetch16(u16 address);
+/* Internal RAM and its decoded-code map (see Mem_Mark_Code), for the
+ * accesses a CPU core knows can only land there: zero page, the stack
+ * and zero page pointers.  Offsets must be below INTERNAL_MEM_SIZE.
+ * MEM_SET_RAM has the same effect as Mem_Set. */
+extern u8 internal_mem[INTERNAL_MEM_SIZE];
+extern u8 ram_code_map[INTERNAL_MEM_SIZE >> 3];
 
-INLINED void Mem_Set(u16 address, u8 value);
-INLINED void Mem_Set16(u16 address, u16 value);
+#define MEM_FETCH_RAM(offset) (internal_mem[(offset)])
+#define MEM_SET_RAM(offset, value)                                     \
+    do {                                                               \
+        register u16 o_ = (offset);                                    \
+        internal_mem[o_] = (value);                                    \
+        if (ram_code_map[o_ >> 3] & (1 << (o_ & 7))) {                 \
+            Cpu_Invalidate_Code(o_);                                   \
+        }                                                              \
+    } while (0)
 
-INLINED u8 *Mem_Get_Ptr(u16 address);
+/* The CPU address space in pages of 256 bytes */
+#define MEM_PAGE_SHIFT  8
+#define MEM_PAGE_SIZE   (1 << MEM_PAGE_SHIFT)
+#define MEM_PAGES       (0x10000 >> MEM_PAGE_SHIFT)
+
+/* Memory each page is read from directly, or 0 where reads have to go
+ * through Mem_Fetch_Io (see Mem_Map_Prg) */
+extern const u8 *mem_read_map[MEM_PAGES];
+
+/* cpu.h includes this header */
+void Cpu_Invalidate_Code(u16 offset);
+
+void Mem_Init(void);
+void Mem_Reset(void);
+
+/* The slow halves of Mem_Fetch and Mem_Set */
+u8 Mem_Fetch_Io(u16 address);
+void Mem_Set_Io(u16 address, u8 value);
+
+/* Func: u8 Mem_Fetch(u16 address)
+ * Desc: Reads a byte the way the CPU does.  Defined here so that every
+ *       core inlines the page table lookup. */
+static inline u8 Mem_Fetch(u16 address) {
+    register const u8 *page = mem_read_map[address >> MEM_PAGE_SHIFT];
+
+    if (page) return page[address & (MEM_PAGE_SIZE - 1)];
+    return Mem_Fetch_Io(address);
+}
+
+static inline u16 Mem_Fetch16(u16 address) {
+    /* Don't forget to test page wraparounds */
+    return TO_U16(Mem_Fetch(address), Mem_Fetch(address + 1));
+}
+
+/* Func: void Mem_Set(u16 address, u8 value)
+ * Desc: Writes a byte the way the CPU does.  Internal RAM is handled
+ *       inline, anything else by Mem_Set_Io. */
+static inline void Mem_Set(u16 address, u8 value) {
+    if (address < 0x2000) MEM_SET_RAM(address % INTERNAL_MEM_SIZE, value);
+    else Mem_Set_Io(address, value);
+}
+
+void Mem_Set16(u16 address, u16 value);
+
+u8 *Mem_Get_Ptr(u16 address);
+
+/* PRG ROM read directly rather than through the cartridge */
+void Mem_Map_Prg(u16 address, u16 length, const u8 *data);
+
+/* PRG RAM at $6000-$7FFF, read and written directly */
+void Mem_Map_Prg_Ram(u8 *data);
+void Mem_Sync_Prg_Ram(void);
+
+/* Func: const u8 *Mem_Get_Page(u16 address)
+ * Desc: The memory the page holding address is read from, indexed by
+ *       the low byte of the address, or 0 if it has to be read through
+ *       Mem_Fetch.  Valid until the next Mem_Map_Prg. */
+static inline const u8 *Mem_Get_Page(u16 address) {
+    return mem_read_map[address >> MEM_PAGE_SHIFT];
+}
+
+/* Tracking of internal RAM that holds decoded code */
+void Mem_Mark_Code(u16 offset, u8 length, u8 is_code);
+void Mem_Clear_Code_Map(void);
+const u8 *Mem_Get_Code_Map(void);
+u8 Mem_Is_Code(u16 address, u16 length);
+
+/* Bulk access, for loops the CPU core runs in one go */
+void Mem_Fill(u16 address, u8 value, u16 length);
+void Mem_Write_Block(u16 address, const u8 *src, u16 length);
+void Mem_Read_Block(u8 *dst, u16 address, u16 length);
 
 void Mem_Dump(void);
 
@@ -141,9 +141,9 @@ u8 Get_Opcode_Length(u8 opcode);
     apply(MODE_INDIRECT_INDEXED, 2)                                     
 
 #define mode(name, length) name,
-enum {
+enum address_modes {
     ADDRESS_MODES(mode)
-} address_modes;
+};
 #undef mode
 
 typedef void(*op_func)(u8);
@@ -151,156 +151,157 @@ typedef void(*op_func)(u8);
 /* Used for distinguishing undocumented opcodes (set to 0). */
 #define _ 0
 
-INLINED void Do_Nmi(void);
+void Do_Nmi(void);
+void Do_Irq(void);
 
-/* Opcode X-macro definition.  Format is (name, mode, cycles).  UNS
+/* Opcode X-macro definition.  Format is (opcode, name, mode, cycles).  UNS
  * stands for "unsupported," and may be needed later for some games.
  * Asterisks (*) next to hex value means that an additional cycle
  * will be necessary for page crossing. */
-#define OPCODE_LIST(op)                                                \
-                                                                       \
-/*        00             01             02             03 */           \
-       op(BRK, IP, 7) op(ORA, IX, 6) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        04             05             06             07 */           \
-       op(UNS, IP, _) op(ORA, ZP, 3) op(ASL, ZP, 5) op(UNS, IP, _)     \
-/*        08             09             0A             0B */           \
-       op(PHP, IP, 3) op(ORA, IM, 2) op(ASL, AC, 2) op(UNS, IP, _)     \
-/*        0C             0D             0E             0F */           \
-       op(UNS, IP, _) op(ORA, AB, 4) op(ASL, AB, 6) op(UNS, IP, _)     \
-                                                                       \
-/*        10*            11*            12             13 */           \
-       op(BPL, RE, 2) op(ORA, IY, 5) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        14             15             16             17 */           \
-       op(UNS, IP, _) op(ORA, ZX, 4) op(ASL, ZX, 6) op(UNS, IP, _)     \
-/*        18             19*            1A             1B */           \
-       op(CLC, IP, 2) op(ORA, AY, 4) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        1C             1D*            1E             1F */           \
-       op(UNS, IP, _) op(ORA, AX, 4) op(ASL, AX, 7) op(UNS, IP, _)     \
-                                                                       \
-/*        20             21             22             23 */           \
-       op(JSR, AB, 6) op(AND, IX, 6) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        24             25             26             27 */           \
-       op(BIT, ZP, 3) op(AND, ZP, 3) op(ROL, ZP, 5) op(UNS, IP, _)     \
-/*        28             29             2A             2B */           \
-       op(PLP, IP, 4) op(AND, IM, 2) op(ROL, AC, 2) op(UNS, IP, _)     \
-/*        2C             2D             2E             2F */           \
-       op(BIT, AB, 4) op(AND, AB, 4) op(ROL, AB, 6) op(UNS, IP, _)     \
-                                                                       \
-/*        30*            31*            32             33 */           \
-       op(BMI, RE, 2) op(AND, IY, 5) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        34             35             36             37 */           \
-       op(UNS, IP, _) op(AND, ZX, 4) op(ROL, ZX, 6) op(UNS, IP, _)     \
-/*        38             39*            3A             3B */           \
-       op(SEC, IP, 2) op(AND, AY, 4) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        3C             3D*            3E             3F */           \
-       op(UNS, IP, _) op(AND, AX, 4) op(ROL, AX, 7) op(UNS, IP, _)     \
-                                                                       \
-/*        40             41             42             43 */           \
-       op(RTI, IP, 6) op(EOR, IX, 6) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        44             45             46             47 */           \
-       op(UNS, IP, _) op(EOR, ZP, 3) op(LSR, ZP, 5) op(UNS, IP, _)     \
-/*        48             49             4A             4B */           \
-       op(PHA, IP, 3) op(EOR, IM, 2) op(LSR, AC, 2) op(UNS, IP, _)     \
-/*        4C             4D             4E             4F */           \
-       op(JMP, AB, 3) op(EOR, AB, 4) op(LSR, AB, 6) op(UNS, IP, _)     \
-                                                                       \
-/*        50*            51*            52             53 */           \
-       op(BVC, RE, 2) op(EOR, IY, 5) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        54             55             56             57 */           \
-       op(UNS, IP, _) op(EOR, ZX, 4) op(LSR, ZX, 6) op(UNS, IP, _)     \
-/*        58             59*            5A             5B */           \
-       op(CLI, IP, 2) op(EOR, AY, 4) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        5C             5D*            5E             5F */           \
-       op(UNS, IP, _) op(EOR, AX, 4) op(LSR, AX, 7) op(UNS, IP, _)     \
-                                                                       \
-/*        60             61             62             63 */           \
-       op(RTS, IP, 6) op(ADC, IX, 6) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        64             65             66             67 */           \
-       op(UNS, IP, _) op(ADC, ZP, 3) op(ROR, ZP, 5) op(UNS, IP, _)     \
-/*        68             69             6A             6B */           \
-       op(PLA, IP, 4) op(ADC, IM, 2) op(ROR, AC, 2) op(UNS, IP, _)     \
-/*        6C             6D             6E             6F */           \
-       op(JMP, IN, 5) op(ADC, AB, 4) op(ROR, AB, 6) op(UNS, IP, _)     \
-                                                                       \
-/*        70*            71*            72             73 */           \
-       op(BVS, RE, 2) op(ADC, IY, 5) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        74             75             76             77 */           \
-       op(UNS, IP, _) op(ADC, ZX, 4) op(ROR, ZX, 6) op(UNS, IP, _)     \
-/*        78             79*            7A             7B */           \
-       op(SEI, IP, 2) op(ADC, AY, 4) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        7C             7D*            7E             7F */           \
-       op(UNS, IP, _) op(ADC, AX, 4) op(ROR, AX, 7) op(UNS, IP, _)     \
-                                                                       \
-/*        80             81             82             83 */           \
-       op(UNS, IP, _) op(STA, IX, 6) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        84             85             86             87 */           \
-       op(STY, ZP, 3) op(STA, ZP, 3) op(STX, ZP, 3) op(UNS, IP, _)     \
-/*        88             89             8A             8B */           \
-       op(DEY, IP, 2) op(UNS, IP, _) op(TXA, IP, 2) op(UNS, IP, _)     \
-/*        8C             8D             8E             8F */           \
-       op(STY, AB, 4) op(STA, AB, 4) op(STX, AB, 4) op(UNS, IP, _)     \
-                                                                       \
-/*        90*            91             92             93 */           \
-       op(BCC, RE, 2) op(STA, IY, 6) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        94             95             96             97 */           \
-       op(STY, ZX, 4) op(STA, ZX, 4) op(STX, ZY, 4) op(UNS, IP, _)     \
-/*        98             99             9A             9B */           \
-       op(TYA, IP, 2) op(STA, AY, 5) op(TXS, IP, 2) op(UNS, IP, _)     \
-/*        9C             9D             9E             9F */           \
-       op(UNS, IP, _) op(STA, AX, 5) op(UNS, IP, _) op(UNS, IP, _)     \
-                                                                       \
-/*        A0             A1             A2             A3 */           \
-       op(LDY, IM, 2) op(LDA, IX, 6) op(LDX, IM, 2) op(UNS, IP, _)     \
-/*        A4             A5             A6             A7 */           \
-       op(LDY, ZP, 3) op(LDA, ZP, 3) op(LDX, ZP, 3) op(UNS, IP, _)     \
-/*        A8             A9             AA             AB */           \
-       op(TAY, IP, 2) op(LDA, IM, 2) op(TAX, IP, 2) op(UNS, IP, _)     \
-/*        AC             AD             AE             AF */           \
-       op(LDY, AB, 4) op(LDA, AB, 4) op(LDX, AB, 4) op(UNS, IP, _)     \
-                                                                       \
-/*        B0*            B1*            B2             B3 */           \
-       op(BCS, RE, 2) op(LDA, IY, 5) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        B4             B5             B6             B7 */           \
-       op(LDY, ZX, 4) op(LDA, ZX, 4) op(LDX, ZY, 4) op(UNS, IP, _)     \
-/*        B8             B9*            BA             BB */           \
-       op(CLV, IP, 2) op(LDA, AY, 4) op(TSX, IP, 2) op(UNS, IP, _)     \
-/*        BC*            BD*            BE*            BF */           \
-       op(LDY, AX, 4) op(LDA, AX, 4) op(LDX, AY, 4) op(UNS, IP, _)     \
-                                                                       \
-/*        C0             C1             C2             C3 */           \
-       op(CPY, IM, 2) op(CMP, IX, 6) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        C4             C5             C6             C7 */           \
-       op(CPY, ZP, 3) op(CMP, ZP, 3) op(DEC, ZP, 5) op(UNS, IP, _)     \
-/*        C8             C9             CA             CB */           \
-       op(INY, IP, 2) op(CMP, IM, 2) op(DEX, IP, 2) op(UNS, IP, _)     \
-/*        CC             CD             CE             CF */           \
-       op(CPY, AB, 4) op(CMP, AB, 4) op(DEC, AB, 6) op(UNS, IP, _)     \
-                                                                       \
-/*        D0*            D1*            D2             D3 */           \
-       op(BNE, RE, 2) op(CMP, IY, 5) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        D4             D5             D6             D7 */           \
-       op(UNS, IP, _) op(CMP, ZX, 4) op(DEC, ZX, 6) op(UNS, IP, _)     \
-/*        D8             D9*            DA             DB */           \
-       op(CLD, IP, 2) op(CMP, AY, 4) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        DC             DD*            DE             DF */           \
-       op(UNS, IP, _) op(CMP, AX, 4) op(DEC, AX, 7) op(UNS, IP, _)     \
-                                                                       \
-/*        E0             E1             E2             E3 */           \
-       op(CPX, IM, 2) op(SBC, IX, 6) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        E4             E5             E6             E7 */           \
-       op(CPX, ZP, 3) op(SBC, ZP, 3) op(INC, ZP, 5) op(UNS, IP, _)     \
-/*        E8             E9             EA             EB */           \
-       op(INX, IP, 2) op(SBC, IM, 2) op(NOP, IP, 2) op(UNS, IP, _)     \
-/*        EC             ED             EE             EF */           \
-       op(CPX, AB, 4) op(SBC, AB, 4) op(INC, AB, 6) op(UNS, IP, _)     \
-                                                                       \
-/*        F0*            F1*            F2             F3 */           \
-       op(BEQ, RE, 2) op(SBC, IY, 5) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        F4             F5             F6             F7 */           \
-       op(UNS, IP, _) op(SBC, ZX, 4) op(INC, ZX, 6) op(UNS, IP, _)     \
-/*        F8             F9*            FA             FB */           \
-       op(SED, IP, 2) op(SBC, AY, 4) op(UNS, IP, _) op(UNS, IP, _)     \
-/*        FC             FD*            FE             FF */           \
-       op(UNS, IP, _) op(SBC, AX, 4) op(INC, AX, 7) op(UNS, IP, _)
+#define OPCODE_LIST(op)                                                                    \
+                                                                                           \
+/*         00                   01                   02                   03 */            \
+       op(0x00, BRK, IP, 7) op(0x01, ORA, IX, 6) op(0x02, UNS, IP, _) op(0x03, UNS, IP, _) \
+/*         04                   05                   06                   07 */            \
+       op(0x04, UNS, IP, _) op(0x05, ORA, ZP, 3) op(0x06, ASL, ZP, 5) op(0x07, UNS, IP, _) \
+/*         08                   09                   0A                   0B */            \
+       op(0x08, PHP, IP, 3) op(0x09, ORA, IM, 2) op(0x0A, ASL, AC, 2) op(0x0B, UNS, IP, _) \
+/*         0C                   0D                   0E                   0F */            \
+       op(0x0C, UNS, IP, _) op(0x0D, ORA, AB, 4) op(0x0E, ASL, AB, 6) op(0x0F, UNS, IP, _) \
+                                                                                           \
+/*         10*                  11*                  12                   13 */            \
+       op(0x10, BPL, RE, 2) op(0x11, ORA, IY, 5) op(0x12, UNS, IP, _) op(0x13, UNS, IP, _) \
+/*         14                   15                   16                   17 */            \
+       op(0x14, UNS, IP, _) op(0x15, ORA, ZX, 4) op(0x16, ASL, ZX, 6) op(0x17, UNS, IP, _) \
+/*         18                   19*                  1A                   1B */            \
+       op(0x18, CLC, IP, 2) op(0x19, ORA, AY, 4) op(0x1A, UNS, IP, _) op(0x1B, UNS, IP, _) \
+/*         1C                   1D*                  1E                   1F */            \
+       op(0x1C, UNS, IP, _) op(0x1D, ORA, AX, 4) op(0x1E, ASL, AX, 7) op(0x1F, UNS, IP, _) \
+                                                                                           \
+/*         20                   21                   22                   23 */            \
+       op(0x20, JSR, AB, 6) op(0x21, AND, IX, 6) op(0x22, UNS, IP, _) op(0x23, UNS, IP, _) \
+/*         24                   25                   26                   27 */            \
+       op(0x24, BIT, ZP, 3) op(0x25, AND, ZP, 3) op(0x26, ROL, ZP, 5) op(0x27, UNS, IP, _) \
+/*         28                   29                   2A                   2B */            \
+       op(0x28, PLP, IP, 4) op(0x29, AND, IM, 2) op(0x2A, ROL, AC, 2) op(0x2B, UNS, IP, _) \
+/*         2C                   2D                   2E                   2F */            \
+       op(0x2C, BIT, AB, 4) op(0x2D, AND, AB, 4) op(0x2E, ROL, AB, 6) op(0x2F, UNS, IP, _) \
+                                                                                           \
+/*         30*                  31*                  32                   33 */            \
+       op(0x30, BMI, RE, 2) op(0x31, AND, IY, 5) op(0x32, UNS, IP, _) op(0x33, UNS, IP, _) \
+/*         34                   35                   36                   37 */            \
+       op(0x34, UNS, IP, _) op(0x35, AND, ZX, 4) op(0x36, ROL, ZX, 6) op(0x37, UNS, IP, _) \
+/*         38                   39*                  3A                   3B */            \
+       op(0x38, SEC, IP, 2) op(0x39, AND, AY, 4) op(0x3A, UNS, IP, _) op(0x3B, UNS, IP, _) \
+/*         3C                   3D*                  3E                   3F */            \
+       op(0x3C, UNS, IP, _) op(0x3D, AND, AX, 4) op(0x3E, ROL, AX, 7) op(0x3F, UNS, IP, _) \
+                                                                                           \
+/*         40                   41                   42                   43 */            \
+       op(0x40, RTI, IP, 6) op(0x41, EOR, IX, 6) op(0x42, UNS, IP, _) op(0x43, UNS, IP, _) \
+/*         44                   45                   46                   47 */            \
+       op(0x44, UNS, IP, _) op(0x45, EOR, ZP, 3) op(0x46, LSR, ZP, 5) op(0x47, UNS, IP, _) \
+/*         48                   49                   4A                   4B */            \
+       op(0x48, PHA, IP, 3) op(0x49, EOR, IM, 2) op(0x4A, LSR, AC, 2) op(0x4B, UNS, IP, _) \
+/*         4C                   4D                   4E                   4F */            \
+       op(0x4C, JMP, AB, 3) op(0x4D, EOR, AB, 4) op(0x4E, LSR, AB, 6) op(0x4F, UNS, IP, _) \
+                                                                                           \
+/*         50*                  51*                  52                   53 */            \
+       op(0x50, BVC, RE, 2) op(0x51, EOR, IY, 5) op(0x52, UNS, IP, _) op(0x53, UNS, IP, _) \
+/*         54                   55                   56                   57 */            \
+       op(0x54, UNS, IP, _) op(0x55, EOR, ZX, 4) op(0x56, LSR, ZX, 6) op(0x57, UNS, IP, _) \
+/*         58                   59*                  5A                   5B */            \
+       op(0x58, CLI, IP, 2) op(0x59, EOR, AY, 4) op(0x5A, UNS, IP, _) op(0x5B, UNS, IP, _) \
+/*         5C                   5D*                  5E                   5F */            \
+       op(0x5C, UNS, IP, _) op(0x5D, EOR, AX, 4) op(0x5E, LSR, AX, 7) op(0x5F, UNS, IP, _) \
+                                                                                           \
+/*         60                   61                   62                   63 */            \
+       op(0x60, RTS, IP, 6) op(0x61, ADC, IX, 6) op(0x62, UNS, IP, _) op(0x63, UNS, IP, _) \
+/*         64                   65                   66                   67 */            \
+       op(0x64, UNS, IP, _) op(0x65, ADC, ZP, 3) op(0x66, ROR, ZP, 5) op(0x67, UNS, IP, _) \
+/*         68                   69                   6A                   6B */            \
+       op(0x68, PLA, IP, 4) op(0x69, ADC, IM, 2) op(0x6A, ROR, AC, 2) op(0x6B, UNS, IP, _) \
+/*         6C                   6D                   6E                   6F */            \
+       op(0x6C, JMP, IN, 5) op(0x6D, ADC, AB, 4) op(0x6E, ROR, AB, 6) op(0x6F, UNS, IP, _) \
+                                                                                           \
+/*         70*                  71*                  72                   73 */            \
+       op(0x70, BVS, RE, 2) op(0x71, ADC, IY, 5) op(0x72, UNS, IP, _) op(0x73, UNS, IP, _) \
+/*         74                   75                   76                   77 */            \
+       op(0x74, UNS, IP, _) op(0x75, ADC, ZX, 4) op(0x76, ROR, ZX, 6) op(0x77, UNS, IP, _) \
+/*         78                   79*                  7A                   7B */            \
+       op(0x78, SEI, IP, 2) op(0x79, ADC, AY, 4) op(0x7A, UNS, IP, _) op(0x7B, UNS, IP, _) \
+/*         7C                   7D*                  7E                   7F */            \
+       op(0x7C, UNS, IP, _) op(0x7D, ADC, AX, 4) op(0x7E, ROR, AX, 7) op(0x7F, UNS, IP, _) \
+                                                                                           \
+/*         80                   81                   82                   83 */            \
+       op(0x80, UNS, IP, _) op(0x81, STA, IX, 6) op(0x82, UNS, IP, _) op(0x83, UNS, IP, _) \
+/*         84                   85                   86                   87 */            \
+       op(0x84, STY, ZP, 3) op(0x85, STA, ZP, 3) op(0x86, STX, ZP, 3) op(0x87, UNS, IP, _) \
+/*         88                   89                   8A                   8B */            \
+       op(0x88, DEY, IP, 2) op(0x89, UNS, IP, _) op(0x8A, TXA, IP, 2) op(0x8B, UNS, IP, _) \
+/*         8C                   8D                   8E                   8F */            \
+       op(0x8C, STY, AB, 4) op(0x8D, STA, AB, 4) op(0x8E, STX, AB, 4) op(0x8F, UNS, IP, _) \
+                                                                                           \
+/*         90*                  91                   92                   93 */            \
+       op(0x90, BCC, RE, 2) op(0x91, STA, IY, 6) op(0x92, UNS, IP, _) op(0x93, UNS, IP, _) \
+/*         94                   95                   96                   97 */            \
+       op(0x94, STY, ZX, 4) op(0x95, STA, ZX, 4) op(0x96, STX, ZY, 4) op(0x97, UNS, IP, _) \
+/*         98                   99                   9A                   9B */            \
+       op(0x98, TYA, IP, 2) op(0x99, STA, AY, 5) op(0x9A, TXS, IP, 2) op(0x9B, UNS, IP, _) \
+/*         9C                   9D                   9E                   9F */            \
+       op(0x9C, UNS, IP, _) op(0x9D, STA, AX, 5) op(0x9E, UNS, IP, _) op(0x9F, UNS, IP, _) \
+                                                                                           \
+/*         A0                   A1                   A2                   A3 */            \
+       op(0xA0, LDY, IM, 2) op(0xA1, LDA, IX, 6) op(0xA2, LDX, IM, 2) op(0xA3, UNS, IP, _) \
+/*         A4                   A5                   A6                   A7 */            \
+       op(0xA4, LDY, ZP, 3) op(0xA5, LDA, ZP, 3) op(0xA6, LDX, ZP, 3) op(0xA7, UNS, IP, _) \
+/*         A8                   A9                   AA                   AB */            \
+       op(0xA8, TAY, IP, 2) op(0xA9, LDA, IM, 2) op(0xAA, TAX, IP, 2) op(0xAB, UNS, IP, _) \
+/*         AC                   AD                   AE                   AF */            \
+       op(0xAC, LDY, AB, 4) op(0xAD, LDA, AB, 4) op(0xAE, LDX, AB, 4) op(0xAF, UNS, IP, _) \
+                                                                                           \
+/*         B0*                  B1*                  B2                   B3 */            \
+       op(0xB0, BCS, RE, 2) op(0xB1, LDA, IY, 5) op(0xB2, UNS, IP, _) op(0xB3, UNS, IP, _) \
+/*         B4                   B5                   B6                   B7 */            \
+       op(0xB4, LDY, ZX, 4) op(0xB5, LDA, ZX, 4) op(0xB6, LDX, ZY, 4) op(0xB7, UNS, IP, _) \
+/*         B8                   B9*                  BA                   BB */            \
+       op(0xB8, CLV, IP, 2) op(0xB9, LDA, AY, 4) op(0xBA, TSX, IP, 2) op(0xBB, UNS, IP, _) \
+/*         BC*                  BD*                  BE*                  BF */            \
+       op(0xBC, LDY, AX, 4) op(0xBD, LDA, AX, 4) op(0xBE, LDX, AY, 4) op(0xBF, UNS, IP, _) \
+                                                                                           \
+/*         C0                   C1                   C2                   C3 */            \
+       op(0xC0, CPY, IM, 2) op(0xC1, CMP, IX, 6) op(0xC2, UNS, IP, _) op(0xC3, UNS, IP, _) \
+/*         C4                   C5                   C6                   C7 */            \
+       op(0xC4, CPY, ZP, 3) op(0xC5, CMP, ZP, 3) op(0xC6, DEC, ZP, 5) op(0xC7, UNS, IP, _) \
+/*         C8                   C9                   CA                   CB */            \
+       op(0xC8, INY, IP, 2) op(0xC9, CMP, IM, 2) op(0xCA, DEX, IP, 2) op(0xCB, UNS, IP, _) \
+/*         CC                   CD                   CE                   CF */            \
+       op(0xCC, CPY, AB, 4) op(0xCD, CMP, AB, 4) op(0xCE, DEC, AB, 6) op(0xCF, UNS, IP, _) \
+                                                                                           \
+/*         D0*                  D1*                  D2                   D3 */            \
+       op(0xD0, BNE, RE, 2) op(0xD1, CMP, IY, 5) op(0xD2, UNS, IP, _) op(0xD3, UNS, IP, _) \
+/*         D4                   D5                   D6                   D7 */            \
+       op(0xD4, UNS, IP, _) op(0xD5, CMP, ZX, 4) op(0xD6, DEC, ZX, 6) op(0xD7, UNS, IP, _) \
+/*         D8                   D9*                  DA                   DB */            \
+       op(0xD8, CLD, IP, 2) op(0xD9, CMP, AY, 4) op(0xDA, UNS, IP, _) op(0xDB, UNS, IP, _) \
+/*         DC                   DD*                  DE                   DF */            \
+       op(0xDC, UNS, IP, _) op(0xDD, CMP, AX, 4) op(0xDE, DEC, AX, 7) op(0xDF, UNS, IP, _) \
+                                                                                           \
+/*         E0                   E1                   E2                   E3 */            \
+       op(0xE0, CPX, IM, 2) op(0xE1, SBC, IX, 6) op(0xE2, UNS, IP, _) op(0xE3, UNS, IP, _) \
+/*         E4                   E5                   E6                   E7 */            \
+       op(0xE4, CPX, ZP, 3) op(0xE5, SBC, ZP, 3) op(0xE6, INC, ZP, 5) op(0xE7, UNS, IP, _) \
+/*         E8                   E9                   EA                   EB */            \
+       op(0xE8, INX, IP, 2) op(0xE9, SBC, IM, 2) op(0xEA, NOP, IP, 2) op(0xEB, UNS, IP, _) \
+/*         EC                   ED                   EE                   EF */            \
+       op(0xEC, CPX, AB, 4) op(0xED, SBC, AB, 4) op(0xEE, INC, AB, 6) op(0xEF, UNS, IP, _) \
+                                                                                           \
+/*         F0*                  F1*                  F2                   F3 */            \
+       op(0xF0, BEQ, RE, 2) op(0xF1, SBC, IY, 5) op(0xF2, UNS, IP, _) op(0xF3, UNS, IP, _) \
+/*         F4                   F5                   F6                   F7 */            \
+       op(0xF4, UNS, IP, _) op(0xF5, SBC, ZX, 4) op(0xF6, INC, ZX, 6) op(0xF7, UNS, IP, _) \
+/*         F8                   F9*                  FA                   FB */            \
+       op(0xF8, SED, IP, 2) op(0xF9, SBC, AY, 4) op(0xFA, UNS, IP, _) op(0xFB, UNS, IP, _) \
+/*         FC                   FD*                  FE                   FF */            \
+       op(0xFC, UNS, IP, _) op(0xFD, SBC, AX, 4) op(0xFE, INC, AX, 7) op(0xFF, UNS, IP, _)
 
 #endif /* #ifndef VNES_OPCODE_H */
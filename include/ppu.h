@@ -16,6 +16,7 @@
 #define VNES_PPU_H
 
 #include "types.h"
+#include "chr-tiles.h"
 
 /* CPU's Memory-mapped PPU Registers */
 #define PPUCTRL   0x2000
@@ -26,6 +27,15 @@
 #define PPUSCROLL 0x2005
 #define PPUADDR   0x2006
 #define PPUDATA   0x2007
+#define OAMDMA    0x4014    /* Page to copy to OAM (Ppu_Oam_Dma) */
+
+/* Nametable mirroring (Set_Nametable_Mirroring).  The first three are
+ * the iNES header's; the single-screen ones are set by mappers. */
+#define MIRROR_HORIZONTAL   0
+#define MIRROR_VERTICAL     1
+#define MIRROR_FOUR_SCREEN  2
+#define MIRROR_SINGLE_LOW   4
+#define MIRROR_SINGLE_HIGH  5
 
 /* PPUCTRL Flags */
 #define NAMETABLE_BASE      0x03
@@ -52,12 +62,34 @@
 #define SPRITE0_HIT     0x40
 #define VBLANK_STARTED  0x80
 
+/* The PPU address space ($0000-$3FFF) in 1K pages: the pattern tables,
+ * pointed at CHR banks by the cartridge (Ppu_Map_Chr), then the four
+ * nametables and their mirror at $3000, pointed into ppu.nt by
+ * Set_Nametable_Mirroring.  The palettes ($3F00-$3FFF) aren't paged. */
+#define PPU_PAGES       16
+#define PPU_PAGE_SIZE   0x400
+#define PPU_CHR_PAGES   8
+#define PPU_NT_PAGE     8   /* Page of the first nametable ($2000) */
+#define PPU_PAGE_TILES  (PPU_PAGE_SIZE / CHR_TILE_BYTES)
+
+/* Sprites on a scanline, as evaluated from OAM (see Ppu_Sprite_Line) */
+#define SPRITES_PER_LINE        8
+#define SPRITE_LINE_ZERO        0x01    /* The first one is sprite 0 */
+#define SPRITE_LINE_OVERFLOW    0x02    /* More were in range */
+
+typedef struct ppu_sprite_line {
+    u8 count;
+    u8 flags;
+    u8 oam[SPRITES_PER_LINE];   /* Offset of each in ppu.oam, in order */
+} ppu_sprite_line;
+
 typedef struct ppu_2c02 {
 	/* PPU Emulation Info */
 	i16 scanline;
 	u32 cycles;
     u32 frame;
     u8 frame_check;
+    u64 synced_at;  /* CPU cycle count the PPU has been run up to */
 	
     u8 last_write;  /* The value last written to PPU */
     
@@ -80,15 +112,43 @@ typedef struct ppu_2c02 {
     
     /* Data storage */
     u8 nt[0x2000];
-    u8 *nt_map[4];
+    u8 *page[PPU_PAGES];    /* See PPU_PAGES */
+    const chr_tile *tiles[PPU_CHR_PAGES];   /* Pattern pages, decoded */
     u8 bg_pal[0x10];
     u8 spr_pal[0x10];
     u8 oam[0x100];
 } ppu_2c02;
 
-INLINED void Ppu_Init(void);
-INLINED void Set_Nametable_Mirroring(u8 mode);
-INLINED void Ppu_Add_Cycles(u32 cycles);
+/* Instance of the ppu (ppu.c) */
+extern ppu_2c02 ppu;
+
+/* Func: u8 Ppu_Peek(u16 addr)
+ * Desc: Reads pattern or nametable data ($0000-$3EFF) through the page
+ *       table, without any of the side effects of PPUDATA. */
+static inline u8 Ppu_Peek(u16 addr) {
+    return ppu.page[(addr >> 10) & (PPU_PAGES - 1)]
+                   [addr & (PPU_PAGE_SIZE - 1)];
+}
+
+/* Func: const chr_tile *Ppu_Tile(u16 addr)
+ * Desc: The decoded tile holding pattern table address addr. */
+static inline const chr_tile *Ppu_Tile(u16 addr) {
+    return ppu.tiles[(addr >> 10) & (PPU_CHR_PAGES - 1)] +
+           ((addr & (PPU_PAGE_SIZE - 1)) / CHR_TILE_BYTES);
+}
+
+void Ppu_Init(void);
+void Set_Nametable_Mirroring(u8 mode);
+void Ppu_Map_Chr(u8 page, u8 *data, const chr_tile *tiles);
+void Ppu_Sync(void);
+void Ppu_Resync(void);
+void Ppu_Restore(void);
+u32 Ppu_Cycles_To_Vram_Access(void);
+void Ppu_Set_A12_Hook(void (*clock)(void), void (*retime)(void));
+u64 Ppu_A12_Rise_At(u32 n);
+void Ppu_Write_Data_Block(const u8 *data, u32 count);
+void Ppu_Oam_Dma(const u8 *data);
+const ppu_sprite_line *Ppu_Sprite_Line(i16 line);
 
 /* Reads coming from CPU */
 u8 Read_Ppu(u16 addr);
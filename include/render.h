@@ -21,9 +21,11 @@
 #define NES_RES_X 256
 #define NES_RES_Y 240
 
-INLINED u32 Sample_Nes_Palette(u8 index);
-INLINED u32 *Get_Render_Buffer(void);
+u32 Sample_Nes_Palette(u8 index);
+u32 *Get_Render_Buffer(void);
 void Render_Scanline(i16 scanline);
+void Render_Vram_Written(u16 addr, u16 count);
+void Render_Invalidate(void);
 void Dump_Render(char *file);
 void Dump_Pattern_Tables(void);
 void Dump_Name_Tables(void);
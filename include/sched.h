@@ -0,0 +1,52 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: sched.h
+ *
+ * Description:
+ *
+ *      Event scheduler.  The timeline is the 64-bit CPU cycle count
+ *      (cpu.cycles), which doesn't wrap in any session; PPU dots are
+ *      three to a cycle, so every PPU event falls on the first CPU
+ *      cycle boundary at or after it, which is where the CPU sees it
+ *      anyway.  Devices set the cycle count their next event is due
+ *      at, and Cpu_Add_Cycles fires it once the count gets there, so
+ *      that the CPU only ever compares against one deadline
+ *      (sched_next) and devices only run when they have to.
+ *
+ *      Events fire between instructions or just before an I/O access,
+ *      never within the CPU's own work on an instruction; interrupts
+ *      they raise are only flagged, and taken at the next instruction
+ *      boundary.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#ifndef VNES_SCHED_H
+#define VNES_SCHED_H
+
+#include "types.h"
+
+/* Events.  Ones due at the same cycle fire lowest first. */
+#define SCHED_VBLANK    0   /* PPU steps onto scanline 241 (may raise NMI) */
+#define SCHED_MAPPER_IRQ 1  /* Cartridge IRQ counter may reach 0 */
+#define SCHED_SPRITE_STATUS 2   /* PPUSTATUS sprite flags may change */
+#define SCHED_EVENTS    3
+
+#define SCHED_NEVER     (~(u64)0)
+
+/* Cycle count the earliest event is due at */
+extern u64 sched_next;
+
+/* Schedules (or moves) an event.  fire is called once cpu.cycles has
+ * reached at, and must schedule the event again if it repeats. */
+void Sched_Set(u8 event, u64 at, void (*fire)(void));
+void Sched_Cancel(u8 event);
+
+/* Fires every event due at or before now, in order */
+void Sched_Run(u64 now);
+
+#endif /* #ifndef VNES_SCHED_H */
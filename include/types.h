@@ -33,6 +33,8 @@ typedef uint16_t    u16;
 typedef int16_t     i16;
 typedef uint32_t    u32;
 typedef int32_t     i32;
+typedef uint64_t    u64;
+typedef int64_t     i64;
 
 #else
 
@@ -42,6 +44,8 @@ typedef unsigned short  u16;
 typedef short           i16;
 typedef unsigned int    u32;
 typedef int             i32;
+typedef unsigned long long  u64;
+typedef long long           i64;
 
 #endif /* #ifdef USE_STDINT */
 
@@ -14,16 +14,26 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "cart.h"
 #include "icart.h"
 #include "ines-cart.h"
 #include "types.h"
 #include "bitwise.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "sched.h"
 
 icart *g_cart = 0;
 
+/* Saves survive however VNES exits normally */
+static void Sync_At_Exit(void) {
+    Sync_Cartridge_Ram(1);
+}
+
 /* Load cartridge, with different options based on file format */
 void Load_Cartridge(char *filename) {
+    static u8 sync_at_exit;
     u8 format[4];
     FILE *fp = fopen(filename, "rb");
     if (!fp) {
@@ -35,9 +45,13 @@ void Load_Cartridge(char *filename) {
     if (0x4E == format[0] && 0x45 == format[1] && 0x53 == format[2] &&
         0x1A == format[3]
     ) {
-            g_cart = Load_iNES(fp);
+            g_cart = Load_iNES(fp, filename);
     }
     fclose(fp);
+    if (g_cart && g_cart->Sync_Ram && !sync_at_exit) {
+        atexit(Sync_At_Exit);
+        sync_at_exit = 1;
+    }
 }
 
 u8 Read_Cartridge_Prg(u16 address) {
@@ -47,9 +61,52 @@ u8 Read_Cartridge_Prg(u16 address) {
     return 0xFF;
 }
 
-u8 Read_Cartridge_Chr(u16 address) {
-	if (g_cart) {
-		return g_cart->Read_Chr(g_cart, address);
-	}
-	return 0xFF;
+u8 Write_Cartridge_Prg(u16 address, u8 value) {
+    if (g_cart) {
+        return g_cart->Write_Prg(g_cart, address, value);
+    }
+    return 0;
+}
+
+u8 Write_Cartridge_Chr(u16 address, u8 value) {
+    if (g_cart) {
+        return g_cart->Write_Chr(g_cart, address, value);
+    }
+    return 0;
+}
+
+/* Func: void Sync_Cartridge_Ram(u8 wait)
+ * Desc: Writes battery-backed RAM back to its file, if the cartridge
+ *       has any; with wait set, returns once it is on disk. */
+void Sync_Cartridge_Ram(u8 wait) {
+    if (g_cart && g_cart->Sync_Ram) g_cart->Sync_Ram(g_cart, wait);
+}
+
+/* Func: void Save_Cartridge_State(u8 *state)
+ * Desc: Copies what the cartridge holds (mapper registers, PRG and CHR
+ *       RAM) out to CART_STATE_SIZE bytes at state. */
+void Save_Cartridge_State(u8 *state) {
+    if (g_cart && g_cart->Save_State) g_cart->Save_State(g_cart, state);
+}
+
+/* Func: void Load_Cartridge_State(const u8 *state)
+ * Desc: Puts the cartridge back the way Save_Cartridge_State found it,
+ *       banks mapped in again.  The PPU's pattern pages aren't touched;
+ *       they are part of the PPU's state. */
+void Load_Cartridge_State(const u8 *state) {
+    if (g_cart && g_cart->Load_State) g_cart->Load_State(g_cart, state);
+}
+
+void Unload_Cartridge(void) {
+    register u8 i;
+
+    if (g_cart) {
+        g_cart->Unload(g_cart);
+        g_cart = 0;
+    }
+    /* Nothing of the board may be left hooked in */
+    Ppu_Set_A12_Hook(0, 0);
+    Sched_Cancel(SCHED_MAPPER_IRQ);
+    Cpu_Ack_Irq(CPU_IRQ_MAPPER);
+    for (i = 0; i < PPU_CHR_PAGES; i++) Ppu_Map_Chr(i, 0, 0);
 }
@@ -0,0 +1,41 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: chr-tiles.c
+ *
+ * Description:
+ *
+ *      Pattern table tile decoding (see chr-tiles.h).
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#include "chr-tiles.h"
+
+/* Func: void Decode_Chr_Row(chr_tile *tile, const u8 *chr, u8 row)
+ * Desc: Decodes a row of the tile whose 16 bytes of CHR start at chr.
+ *       The low plane is chr[row], the high plane chr[row + 8], most
+ *       significant bit leftmost. */
+void Decode_Chr_Row(chr_tile *tile, const u8 *chr, u8 row) {
+    register u8 low = chr[row], high = chr[row + 8];
+    register u8 x, v;
+
+    for (x = 0; x < 8; x++) {
+        v = ((low >> (7 - x)) & 1) | (((high >> (7 - x)) & 1) << 1);
+        tile->pixel[row][x] = v;
+        tile->flipped[row][7 - x] = v;
+    }
+}
+
+/* Func: void Decode_Chr_Tiles(chr_tile *tiles, const u8 *chr, u32 count)
+ * Desc: Decodes count consecutive tiles of CHR. */
+void Decode_Chr_Tiles(chr_tile *tiles, const u8 *chr, u32 count) {
+    register u8 row;
+
+    for (; count; count--, tiles++, chr += CHR_TILE_BYTES) {
+        for (row = 0; row < 8; row++) Decode_Chr_Row(tiles, chr, row);
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: cpu-aot.c
+ *
+ * Description:
+ *
+ *      Loads PRG ROM translated ahead of time by recomp (a shared
+ *      object built from its output) and hands its functions to the
+ *      block cache.  A translated block is only used for a decoded
+ *      block with the same start, length and bytes, so code that was
+ *      never reached by recomp, other PRG banks and anything that
+ *      changed since are interpreted as before.  Only built when
+ *      USE_AOT is defined.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#include "cpu.h"
+#include "mem.h"
+#include "cpu-aot.h"
+#include <string.h>
+
+#ifdef USE_AOT
+#include <dlfcn.h>
+
+extern cpu_6502 cpu;
+
+#define ROM_BASE    0x8000
+#define ROM_SIZE    0x8000
+
+static aot_host host;
+static void *aot_handle;
+static const aot_block *aot_index[ROM_SIZE];
+
+native_block Aot_Find(const decoded_block *blk) {
+    register const aot_block *ab;
+    register u32 hash = AOT_HASH_INIT;
+    register u8 i;
+
+    if (blk->pc < ROM_BASE) return 0;
+    ab = aot_index[blk->pc - ROM_BASE];
+    if (!ab || ab->bytes != blk->bytes) return 0;
+    for (i = 0; i < blk->bytes; i++) {
+        hash = AOT_HASH_STEP(hash, Mem_Fetch(blk->pc + i));
+    }
+    return (hash == ab->hash) ? ab->run : 0;
+}
+#endif /* #ifdef USE_AOT */
+
+/* Func: u8 Cpu_Load_Aot(const char *path)
+ * Desc: Loads a module built from recomp output.  Returns 1 on success,
+ *       0 if it can't be loaded (or this build has no USE_AOT), in
+ *       which case everything is interpreted as before. */
+u8 Cpu_Load_Aot(const char *path) {
+#ifdef USE_AOT
+    register const aot_module *module;
+    register u32 i;
+    void *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+
+    if (!handle) {
+        fprintf(stderr, "%s\n", dlerror());
+        return 0;
+    }
+    module = (const aot_module *)dlsym(handle, AOT_SYMBOL);
+    if (!module || AOT_VERSION != module->version) {
+        fprintf(stderr, "%s: not a VNES AOT module\n", path);
+        dlclose(handle);
+        return 0;
+    }
+
+    host.cpu = &cpu;
+    host.ram = Mem_Get_Ptr(0);
+    host.code_map = Mem_Get_Code_Map();
+    host.read = Mem_Fetch;
+    host.write = Mem_Set;
+    host.add_cycles = Cpu_Add_Cycles;
+    host.invalidate = Cpu_Invalidate_Code;
+    module->bind(&host);
+
+    memset(aot_index, 0, sizeof(aot_index));
+    for (i = 0; i < module->count; i++) {
+        if (module->blocks[i].pc >= ROM_BASE) {
+            aot_index[module->blocks[i].pc - ROM_BASE] = &module->blocks[i];
+        }
+    }
+
+    /* Blocks decoded so far pick the new code up when decoded again */
+    Cpu_Flush_Blocks();
+    if (aot_handle) dlclose(aot_handle);
+    aot_handle = handle;
+    return 1;
+#else
+    return 0;
+#endif /* #ifdef USE_AOT */
+}
@@ -0,0 +1,785 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: cpu-jit.c
+ *
+ * Description:
+ *
+ *      Translates hot PRG ROM blocks from the block cache into x86-64
+ *      code.  A, X, Y and P stay in callee-saved host registers for the
+ *      whole block, internal RAM is accessed directly, and PRG ROM is
+ *      read through Mem_Fetch.  Anything that could touch the PPU or
+ *      other I/O is left to the interpreter: a block is cut short in
+ *      front of an instruction with a fixed I/O address, and an indexed
+ *      access that turns out to hit I/O at run time leaves the block
+ *      (a side exit) before the instruction has done anything.
+ *
+ *      Generated code returns the cycles it ran, and the caller adds
+ *      them in one go.  That is only exact because the caller never
+ *      runs a block that could cross the next scheduled event (such as
+ *      vblank, see sched.h), and because blocks never touch the PPU
+ *      themselves.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#include "cpu.h"
+#include "mem.h"
+#include "opcode.h"
+#include "bitwise.h"
+#include "cpu-jit.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef USE_JIT
+#include <sys/mman.h>
+
+extern cpu_6502 cpu;
+
+/* From opcode.c */
+extern const u8 op_mode[];
+
+#define ARENA_SIZE      (1 << 20)
+#define MAX_BLOCK_CODE  4096
+#define MAX_EXITS       (BLOCK_MAX_OPS * 2 + 2)
+
+#define RAM_END         0x2000
+#define RAM_MASK        0x07FF
+#define ROM_BASE        0x8000
+#define STACK_PAGE      0x0100
+
+/* Host registers */
+enum {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+/* 6502 state lives in callee-saved registers so that calls back into
+ * C leave it alone.  RAX, RCX, RDX and RSI are scratch. */
+#define HA      R12
+#define HX      R13
+#define HY      R14
+#define HP      R15
+#define HNZ     RBX     /* nz_flags[] */
+#define HRAM    RBP     /* Internal RAM */
+
+/* Group 1 ALU operations (the /digit of opcode 0x81) */
+#define ALU_ADD 0
+#define ALU_OR  1
+#define ALU_AND 4
+#define ALU_SUB 5
+#define ALU_XOR 6
+#define ALU_CMP 7
+
+/* Shifts (the /digit of opcode 0xC1) */
+#define SH_SHL  4
+#define SH_SHR  5
+
+/* Condition codes */
+#define CC_B    0x2
+#define CC_AE   0x3
+#define CC_E    0x4
+#define CC_NE   0x5
+
+/* Instructions, in the order OPCODE_LIST names them */
+enum {
+    I_ADC, I_AND, I_ASL, I_BCC, I_BCS, I_BEQ, I_BIT, I_BMI, I_BNE, I_BPL,
+    I_BRK, I_BVC, I_BVS, I_CLC, I_CLD, I_CLI, I_CLV, I_CMP, I_CPX, I_CPY,
+    I_DEC, I_DEX, I_DEY, I_EOR, I_INC, I_INX, I_INY, I_JMP, I_JSR, I_LDA,
+    I_LDX, I_LDY, I_LSR, I_NOP, I_ORA, I_PHA, I_PHP, I_PLA, I_PLP, I_ROL,
+    I_ROR, I_RTI, I_RTS, I_SBC, I_SEC, I_SED, I_SEI, I_STA, I_STX, I_STY,
+    I_TAX, I_TAY, I_TSX, I_TXA, I_TXS, I_TYA, I_UNS
+};
+
+#define OP(code, name, mode, cycles) I_##name,
+static const u8 op_insn[] = {
+    OPCODE_LIST(OP)
+};
+#undef OP
+
+#define OP(code, name, mode, cycles) cycles,
+static const u8 op_cycles[] = {
+    OPCODE_LIST(OP)
+};
+#undef OP
+
+/* A place the generated code leaves the block from.  The stubs are
+ * emitted after the block body. */
+typedef struct jit_exit {
+    u8 *jump;           /* rel32 field of the jump to the stub */
+    u16 pc;             /* PC to leave with */
+    u32 cycles;         /* Cycles run by the block up to here */
+    u8 invalidate;      /* RAM offset in EAX holds code; drop it first */
+} jit_exit;
+
+static u8 *arena, *out;
+static jit_exit exits[MAX_EXITS];
+static u32 exit_count;
+static u8 overflow;
+
+/* N and Z for every result */
+static u8 nz_flags[256];
+
+/* Byte emitters */
+static void B(u8 b) {
+    *out++ = b;
+}
+
+static void D(u32 d) {
+    memcpy(out, &d, 4);
+    out += 4;
+}
+
+static void Ptr(const void *p) {
+    memcpy(out, &p, sizeof(p));
+    out += sizeof(p);
+}
+
+/* REX prefix; emitted when needed or when byte registers are used
+ * (forcing it selects SIL/DIL and friends over AH/BH). */
+static void Rex(u8 w, u8 reg, u8 index, u8 base, u8 force) {
+    u8 rex = 0x40 | (w << 3) | ((reg & 8) >> 1) | ((index & 8) >> 2)
+           | ((base & 8) >> 3);
+    if (rex != 0x40 || force) B(rex);
+}
+
+static void ModRM(u8 mod, u8 reg, u8 rm) {
+    B((mod << 6) | ((reg & 7) << 3) | (rm & 7));
+}
+
+/* [base + index + disp32] */
+static void Mem_BI(u8 reg, u8 base, u8 index, u32 disp) {
+    ModRM(2, reg, 4);
+    B(((index & 7) << 3) | (base & 7));
+    D(disp);
+}
+
+/* mov dst32, src32 */
+static void Mov_RR(u8 dst, u8 src) {
+    Rex(0, src, 0, dst, 0); B(0x89); ModRM(3, src, dst);
+}
+
+/* mov dst32, imm32 */
+static void Mov_RI(u8 dst, u32 imm) {
+    Rex(0, 0, 0, dst, 0); B(0xB8 | (dst & 7)); D(imm);
+}
+
+/* mov dst64, imm64 */
+static void Mov_RP(u8 dst, const void *p) {
+    Rex(1, 0, 0, dst, 0); B(0xB8 | (dst & 7)); Ptr(p);
+}
+
+/* op dst32, imm32 */
+static void Alu_RI(u8 op, u8 dst, u32 imm) {
+    Rex(0, 0, 0, dst, 0); B(0x81); ModRM(3, op, dst); D(imm);
+}
+
+/* op dst32, src32 */
+static void Alu_RR(u8 op, u8 dst, u8 src) {
+    Rex(0, src, 0, dst, 0); B((op << 3) | 1); ModRM(3, src, dst);
+}
+
+/* shl/shr dst32, imm8 */
+static void Shift_RI(u8 op, u8 dst, u8 n) {
+    Rex(0, 0, 0, dst, 0); B(0xC1); ModRM(3, op, dst); B(n);
+}
+
+/* movzx dst32, src8 */
+static void Movzx_RR8(u8 dst, u8 src) {
+    Rex(0, dst, 0, src, 1); B(0x0F); B(0xB6); ModRM(3, dst, src);
+}
+
+/* movzx dst32, byte [base + disp32]; base must not be RSP/R12 */
+static void Load8_BD(u8 dst, u8 base, u32 disp) {
+    Rex(0, dst, 0, base, 0); B(0x0F); B(0xB6); ModRM(2, dst, base); D(disp);
+}
+
+/* movzx dst32, byte [base + index + disp32]; index must not be RSP */
+static void Load8_BI(u8 dst, u8 base, u8 index, u32 disp) {
+    Rex(0, dst, index, base, 0); B(0x0F); B(0xB6); Mem_BI(dst, base, index, disp);
+}
+
+/* mov byte [base + disp32], src8 */
+static void Store8_BD(u8 src, u8 base, u32 disp) {
+    Rex(0, src, 0, base, 1); B(0x88); ModRM(2, src, base); D(disp);
+}
+
+/* mov byte [base + index + disp32], src8 */
+static void Store8_BI(u8 src, u8 base, u8 index, u32 disp) {
+    Rex(0, src, index, base, 1); B(0x88); Mem_BI(src, base, index, disp);
+}
+
+/* test a32, b32 */
+static void Test_RR(u8 a, u8 b) {
+    Rex(0, b, 0, a, 0); B(0x85); ModRM(3, b, a);
+}
+
+/* test r32, imm32 */
+static void Test_RI(u8 r, u32 imm) {
+    Rex(0, 0, 0, r, 0); B(0xF7); ModRM(3, 0, r); D(imm);
+}
+
+/* setcc dst8; movzx dst32, dst8 */
+static void Setcc(u8 cc, u8 dst) {
+    Rex(0, 0, 0, dst, 1); B(0x0F); B(0x90 | cc); ModRM(3, 0, dst);
+    Movzx_RR8(dst, dst);
+}
+
+/* bt dword [base], bit32 */
+static void Bt_MR(u8 base, u8 bit) {
+    Rex(0, bit, 0, base, 0); B(0x0F); B(0xA3); ModRM(0, bit, base);
+}
+
+/* add dword [rsp], src32 */
+static void Add_Stack(u8 src) {
+    Rex(0, src, 0, 0, 0); B(0x01); ModRM(0, src, 4); B(0x24);
+}
+
+/* Jumps return the rel32 field, to be patched once the target is known */
+static u8 *Jcc(u8 cc) {
+    B(0x0F); B(0x80 | cc); D(0);
+    return out - 4;
+}
+
+static u8 *Jmp(void) {
+    B(0xE9); D(0);
+    return out - 4;
+}
+
+static void Patch(u8 *jump, const u8 *target) {
+    i32 rel = (i32)(target - (jump + 4));
+    memcpy(jump, &rel, 4);
+}
+
+static void Call(const void *fn) {
+    Mov_RP(RAX, fn);
+    B(0xFF); ModRM(3, 2, RAX);
+}
+
+static void Add_Exit(u8 *jump, u16 pc, u32 cycles, u8 invalidate) {
+    jit_exit *e;
+    if (MAX_EXITS == exit_count) {
+        overflow = 1;
+        return;
+    }
+    e = &exits[exit_count++];
+    e->jump = jump;
+    e->pc = pc;
+    e->cycles = cycles;
+    e->invalidate = invalidate;
+}
+
+/* P = (P & ~(N|Z)) | nz_flags[r] */
+static void Set_NZ(u8 r) {
+    Alu_RI(ALU_AND, HP, (u8)~(FLG_SIGN | FLG_ZERO));
+    Load8_BI(RCX, HNZ, r, 0);
+    Alu_RR(ALU_OR, HP, RCX);
+}
+
+/* Does the instruction write memory? */
+static u8 Writes(u8 insn) {
+    switch (insn) {
+        case I_STA: case I_STX: case I_STY:
+        case I_ASL: case I_LSR: case I_ROL: case I_ROR:
+        case I_INC: case I_DEC:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* Can the instruction be translated?  Fixed I/O addresses never are;
+ * PRG ROM may be read (through Mem_Fetch) but not written. */
+static u8 Supported(const decoded_op *op) {
+    u8 insn = op_insn[op->opcode];
+    u8 mode = op_mode[op->opcode];
+
+    switch (insn) {
+        case I_BRK: case I_JSR: case I_RTI: case I_RTS: case I_UNS:
+            return 0;
+        case I_JMP:
+            return AB == mode;
+        default:
+            break;
+    }
+    if (AB == mode && op->operand >= RAM_END) {
+        return op->operand >= ROM_BASE && !Writes(insn);
+    }
+    return 1;
+}
+
+/* EAX = (u8)(operand + index) */
+static void Zero_Page_Indexed(u8 index, u16 operand) {
+    Mov_RR(RAX, index);
+    Alu_RI(ALU_ADD, RAX, operand);
+    Movzx_RR8(RAX, RAX);
+}
+
+/* EAX = effective address of an indexed or indirect mode.  ECX gets
+ * the page-crossing penalty for the modes that have one. */
+static void Indexed_Address(u8 mode, u16 operand) {
+    u8 index = (AY == mode) ? HY : HX;
+
+    switch (mode) {
+        case AX: case AY:
+            Mov_RR(RCX, index);
+            Alu_RI(ALU_ADD, RCX, operand & 0xFF);
+            Shift_RI(SH_SHR, RCX, 8);
+            Mov_RR(RAX, index);
+            Alu_RI(ALU_ADD, RAX, operand);
+            Alu_RI(ALU_AND, RAX, 0xFFFF);
+            break;
+        case IX:
+            Mov_RR(RCX, HX);
+            Alu_RI(ALU_ADD, RCX, operand);
+            Movzx_RR8(RCX, RCX);
+            Load8_BI(RAX, HRAM, RCX, 0);
+            Alu_RI(ALU_ADD, RCX, 1);
+            Movzx_RR8(RCX, RCX);
+            Load8_BI(RDX, HRAM, RCX, 0);
+            Shift_RI(SH_SHL, RDX, 8);
+            Alu_RR(ALU_OR, RAX, RDX);
+            break;
+        case IY:
+            Load8_BD(RAX, HRAM, operand & 0xFF);
+            Load8_BD(RDX, HRAM, (operand + 1) & 0xFF);
+            Shift_RI(SH_SHL, RDX, 8);
+            Alu_RR(ALU_OR, RAX, RDX);
+            Movzx_RR8(RCX, RAX);
+            Alu_RR(ALU_ADD, RCX, HY);
+            Shift_RI(SH_SHR, RCX, 8);
+            Alu_RR(ALU_ADD, RAX, HY);
+            Alu_RI(ALU_AND, RAX, 0xFFFF);
+            break;
+    }
+}
+
+static void Add_Penalty(u8 mode) {
+    if (IX != mode) Add_Stack(RCX);
+}
+
+/* EDX = operand value.  pc/cycles locate the instruction for the side
+ * exit taken when an indexed read hits I/O. */
+static void Emit_Read(u8 mode, u16 operand, u16 pc, u32 cycles) {
+    u8 *not_ram, *done;
+
+    switch (mode) {
+        case IM:
+            Mov_RI(RDX, operand & 0xFF);
+            break;
+        case ZP:
+            Load8_BD(RDX, HRAM, operand & 0xFF);
+            break;
+        case ZX: case ZY:
+            Zero_Page_Indexed((ZX == mode) ? HX : HY, operand);
+            Load8_BI(RDX, HRAM, RAX, 0);
+            break;
+        case AB:
+            if (operand < RAM_END) {
+                Load8_BD(RDX, HRAM, operand & RAM_MASK);
+            } else {
+                Mov_RI(RDI, operand);
+                Call(Mem_Fetch);
+                Movzx_RR8(RDX, RAX);
+            }
+            break;
+        default:
+            Indexed_Address(mode, operand);
+            Alu_RI(ALU_CMP, RAX, RAM_END);
+            not_ram = Jcc(CC_AE);
+            Add_Penalty(mode);
+            Alu_RI(ALU_AND, RAX, RAM_MASK);
+            Load8_BI(RDX, HRAM, RAX, 0);
+            done = Jmp();
+            Patch(not_ram, out);
+            Alu_RI(ALU_CMP, RAX, ROM_BASE);
+            Add_Exit(Jcc(CC_B), pc, cycles, 0);
+            Add_Penalty(mode);
+            Mov_RR(RDI, RAX);
+            Call(Mem_Fetch);
+            Movzx_RR8(RDX, RAX);
+            Patch(done, out);
+            break;
+    }
+}
+
+/* EAX = RAM offset written by a store or read-modify-write.  Indexed
+ * modes leave the block if the address isn't internal RAM. */
+static void Emit_Ram_Address(u8 mode, u16 operand, u16 pc, u32 cycles) {
+    switch (mode) {
+        case ZP:
+            Mov_RI(RAX, operand & 0xFF);
+            break;
+        case ZX: case ZY:
+            Zero_Page_Indexed((ZX == mode) ? HX : HY, operand);
+            break;
+        case AB:
+            Mov_RI(RAX, operand & RAM_MASK);
+            break;
+        default:
+            Indexed_Address(mode, operand);
+            Alu_RI(ALU_CMP, RAX, RAM_END);
+            Add_Exit(Jcc(CC_AE), pc, cycles, 0);
+            Alu_RI(ALU_AND, RAX, RAM_MASK);
+            break;
+    }
+}
+
+/* After a store to the RAM offset in EAX: if the byte was decoded into
+ * a block, invalidate it and leave, since that might be this block. */
+static void Emit_Code_Check(u16 next_pc, u32 cycles) {
+    Mov_RP(RSI, Mem_Get_Code_Map());
+    Bt_MR(RSI, RAX);
+    Add_Exit(Jcc(CC_B), next_pc, cycles, 1);
+}
+
+/* Push src8 */
+static void Emit_Push(u8 src, u16 next_pc, u32 cycles) {
+    Mov_RP(RSI, &cpu.s);
+    Load8_BD(RAX, RSI, 0);
+    Store8_BI(src, HRAM, RAX, STACK_PAGE);
+    Mov_RR(RCX, RAX);
+    Alu_RI(ALU_SUB, RCX, 1);
+    Store8_BD(RCX, RSI, 0);
+    Alu_RI(ALU_ADD, RAX, STACK_PAGE);
+    Emit_Code_Check(next_pc, cycles);
+}
+
+/* EDX = pulled byte */
+static void Emit_Pull(void) {
+    Mov_RP(RSI, &cpu.s);
+    Load8_BD(RAX, RSI, 0);
+    Alu_RI(ALU_ADD, RAX, 1);
+    Movzx_RR8(RAX, RAX);
+    Store8_BD(RAX, RSI, 0);
+    Load8_BI(RDX, HRAM, RAX, STACK_PAGE);
+}
+
+/* A = A + EDX + C */
+static void Emit_Add(void) {
+    Mov_RR(RAX, HA);
+    Alu_RR(ALU_ADD, RAX, RDX);
+    Mov_RR(RCX, HP);
+    Alu_RI(ALU_AND, RCX, FLG_CARRY);
+    Alu_RR(ALU_ADD, RAX, RCX);
+    /* V = (A ^ s) & (v ^ s) & 0x80 */
+    Mov_RR(RCX, HA);
+    Alu_RR(ALU_XOR, RCX, RAX);
+    Alu_RR(ALU_XOR, RDX, RAX);
+    Alu_RR(ALU_AND, RCX, RDX);
+    Alu_RI(ALU_AND, RCX, 0x80);
+    Shift_RI(SH_SHR, RCX, 1);
+    Alu_RI(ALU_AND, HP, (u8)~(FLG_OVERFLOW | FLG_CARRY));
+    Alu_RR(ALU_OR, HP, RCX);
+    /* C = s >> 8 */
+    Mov_RR(RCX, RAX);
+    Shift_RI(SH_SHR, RCX, 8);
+    Alu_RR(ALU_OR, HP, RCX);
+    Movzx_RR8(HA, RAX);
+    Set_NZ(HA);
+}
+
+static void Emit_Compare(u8 reg) {
+    Alu_RI(ALU_AND, HP, (u8)~FLG_CARRY);
+    Mov_RR(RAX, reg);
+    Alu_RR(ALU_SUB, RAX, RDX);
+    Setcc(CC_AE, RCX);
+    Alu_RR(ALU_OR, HP, RCX);
+    Movzx_RR8(RAX, RAX);
+    Set_NZ(RAX);
+}
+
+/* Shifts and rotates of EDX */
+static void Emit_Shift(u8 insn) {
+    if (I_ROL == insn || I_ROR == insn) {
+        Mov_RR(RSI, HP);
+        Alu_RI(ALU_AND, RSI, FLG_CARRY);
+        if (I_ROR == insn) Shift_RI(SH_SHL, RSI, 7);
+    }
+    Mov_RR(RCX, RDX);
+    if (I_ASL == insn || I_ROL == insn) Shift_RI(SH_SHR, RCX, 7);
+    else Alu_RI(ALU_AND, RCX, FLG_CARRY);
+    Alu_RI(ALU_AND, HP, (u8)~FLG_CARRY);
+    Alu_RR(ALU_OR, HP, RCX);
+    if (I_ASL == insn || I_ROL == insn) Shift_RI(SH_SHL, RDX, 1);
+    else Shift_RI(SH_SHR, RDX, 1);
+    if (I_ROL == insn || I_ROR == insn) Alu_RR(ALU_OR, RDX, RSI);
+    Movzx_RR8(RDX, RDX);
+    Set_NZ(RDX);
+}
+
+/* Read-modify-write of EDX */
+static void Emit_Modify(u8 insn) {
+    switch (insn) {
+        case I_INC: case I_DEC:
+            Alu_RI((I_INC == insn) ? ALU_ADD : ALU_SUB, RDX, 1);
+            Movzx_RR8(RDX, RDX);
+            Set_NZ(RDX);
+            break;
+        default:
+            Emit_Shift(insn);
+            break;
+    }
+}
+
+static void Emit_Branch(u8 flag, u8 if_set, u16 pc, u16 operand, u32 cycles) {
+    u16 next = pc + 2;
+    u16 target = next + (i8)operand;
+    u32 taken = cycles + ((PAGE_OF(next) == PAGE_OF(target)) ? 1 : 2);
+
+    Test_RI(HP, flag);
+    Add_Exit(Jcc(if_set ? CC_NE : CC_E), target, taken, 0);
+    Add_Exit(Jmp(), next, cycles, 0);
+}
+
+/* Translates one instruction that was at pc after the block had run
+ * `cycles` cycles.  Returns 1 if the instruction ends the block. */
+static u8 Emit_Insn(const decoded_op *op, u16 pc, u32 cycles) {
+    u8 insn = op_insn[op->opcode];
+    u8 mode = op_mode[op->opcode];
+    u16 operand = op->operand;
+    u16 next = pc + op->length;
+    u32 after = cycles + op_cycles[op->opcode];
+    u8 reg;
+
+    switch (insn) {
+        /* Loads and ALU */
+        case I_LDA: case I_LDX: case I_LDY:
+            reg = (I_LDA == insn) ? HA : (I_LDX == insn) ? HX : HY;
+            Emit_Read(mode, operand, pc, cycles);
+            Mov_RR(reg, RDX);
+            Set_NZ(reg);
+            break;
+        case I_AND: case I_ORA: case I_EOR:
+            Emit_Read(mode, operand, pc, cycles);
+            Alu_RR((I_AND == insn) ? ALU_AND : (I_ORA == insn) ? ALU_OR : ALU_XOR,
+                   HA, RDX);
+            Set_NZ(HA);
+            break;
+        case I_ADC: case I_SBC:
+            Emit_Read(mode, operand, pc, cycles);
+            if (I_SBC == insn) Alu_RI(ALU_XOR, RDX, 0xFF);
+            Emit_Add();
+            break;
+        case I_CMP: case I_CPX: case I_CPY:
+            Emit_Read(mode, operand, pc, cycles);
+            Emit_Compare((I_CMP == insn) ? HA : (I_CPX == insn) ? HX : HY);
+            break;
+        case I_BIT:
+            Emit_Read(mode, operand, pc, cycles);
+            Alu_RI(ALU_AND, HP, (u8)~(FLG_ZERO | FLG_OVERFLOW | FLG_SIGN));
+            Mov_RR(RCX, RDX);
+            Alu_RI(ALU_AND, RCX, FLG_OVERFLOW | FLG_SIGN);
+            Alu_RR(ALU_OR, HP, RCX);
+            Test_RR(HA, RDX);
+            Setcc(CC_E, RCX);
+            Shift_RI(SH_SHL, RCX, 1);
+            Alu_RR(ALU_OR, HP, RCX);
+            break;
+
+        /* Stores and read-modify-write */
+        case I_STA: case I_STX: case I_STY:
+            reg = (I_STA == insn) ? HA : (I_STX == insn) ? HX : HY;
+            Emit_Ram_Address(mode, operand, pc, cycles);
+            Store8_BI(reg, HRAM, RAX, 0);
+            Emit_Code_Check(next, after);
+            break;
+        case I_ASL: case I_LSR: case I_ROL: case I_ROR:
+        case I_INC: case I_DEC:
+            if (AC == mode) {
+                Mov_RR(RDX, HA);
+                Emit_Modify(insn);
+                Mov_RR(HA, RDX);
+                break;
+            }
+            Emit_Ram_Address(mode, operand, pc, cycles);
+            Load8_BI(RDX, HRAM, RAX, 0);
+            Emit_Modify(insn);
+            Store8_BI(RDX, HRAM, RAX, 0);
+            Emit_Code_Check(next, after);
+            break;
+
+        /* Registers */
+        case I_INX: case I_INY: case I_DEX: case I_DEY:
+            reg = (I_INX == insn || I_DEX == insn) ? HX : HY;
+            Alu_RI((I_INX == insn || I_INY == insn) ? ALU_ADD : ALU_SUB, reg, 1);
+            Movzx_RR8(reg, reg);
+            Set_NZ(reg);
+            break;
+        case I_TAX: Mov_RR(HX, HA); Set_NZ(HX); break;
+        case I_TAY: Mov_RR(HY, HA); Set_NZ(HY); break;
+        case I_TXA: Mov_RR(HA, HX); Set_NZ(HA); break;
+        case I_TYA: Mov_RR(HA, HY); Set_NZ(HA); break;
+        case I_TSX:
+            Mov_RP(RSI, &cpu.s);
+            Load8_BD(HX, RSI, 0);
+            Set_NZ(HX);
+            break;
+        case I_TXS:
+            Mov_RP(RSI, &cpu.s);
+            Store8_BD(HX, RSI, 0);
+            break;
+
+        /* Flags */
+        case I_CLC: Alu_RI(ALU_AND, HP, (u8)~FLG_CARRY); break;
+        case I_CLD: Alu_RI(ALU_AND, HP, (u8)~FLG_DECIMAL); break;
+        case I_CLI: Alu_RI(ALU_AND, HP, (u8)~FLG_INT_DIS); break;
+        case I_CLV: Alu_RI(ALU_AND, HP, (u8)~FLG_OVERFLOW); break;
+        case I_SEC: Alu_RI(ALU_OR, HP, FLG_CARRY); break;
+        case I_SED: Alu_RI(ALU_OR, HP, FLG_DECIMAL); break;
+        case I_SEI: Alu_RI(ALU_OR, HP, FLG_INT_DIS); break;
+        case I_NOP: break;
+
+        /* Stack */
+        case I_PHA:
+            Emit_Push(HA, next, after);
+            break;
+        case I_PHP:
+            Mov_RR(RDX, HP);
+            Alu_RI(ALU_OR, RDX, FLG_BRK);
+            Emit_Push(RDX, next, after);
+            break;
+        case I_PLA:
+            Emit_Pull();
+            Mov_RR(HA, RDX);
+            Set_NZ(HA);
+            break;
+        case I_PLP:
+            Emit_Pull();
+            Alu_RI(ALU_AND, RDX, (u8)~FLG_BRK);
+            Alu_RI(ALU_OR, RDX, FLG_NOT_USED);
+            Mov_RR(HP, RDX);
+            break;
+
+        /* Control flow */
+        case I_BCC: Emit_Branch(FLG_CARRY, 0, pc, operand, after); return 1;
+        case I_BCS: Emit_Branch(FLG_CARRY, 1, pc, operand, after); return 1;
+        case I_BNE: Emit_Branch(FLG_ZERO, 0, pc, operand, after); return 1;
+        case I_BEQ: Emit_Branch(FLG_ZERO, 1, pc, operand, after); return 1;
+        case I_BPL: Emit_Branch(FLG_SIGN, 0, pc, operand, after); return 1;
+        case I_BMI: Emit_Branch(FLG_SIGN, 1, pc, operand, after); return 1;
+        case I_BVC: Emit_Branch(FLG_OVERFLOW, 0, pc, operand, after); return 1;
+        case I_BVS: Emit_Branch(FLG_OVERFLOW, 1, pc, operand, after); return 1;
+        case I_JMP:
+            Add_Exit(Jmp(), operand, after, 0);
+            return 1;
+    }
+    return 0;
+}
+
+static void Emit_Prologue(void) {
+    B(0x53);                            /* push rbx */
+    B(0x55);                            /* push rbp */
+    B(0x41); B(0x54);                   /* push r12 */
+    B(0x41); B(0x55);                   /* push r13 */
+    B(0x41); B(0x56);                   /* push r14 */
+    B(0x41); B(0x57);                   /* push r15 */
+    B(0x48); B(0x83); B(0xEC); B(0x08); /* sub rsp, 8 (keeps calls aligned) */
+    B(0xC7); B(0x04); B(0x24); D(0);    /* dword [rsp] = 0: extra cycles */
+
+    Mov_RP(HNZ, nz_flags);
+    Mov_RP(HRAM, Mem_Get_Ptr(0));
+    Mov_RP(RAX, &cpu);
+    Load8_BD(HA, RAX, offsetof(cpu_6502, a));
+    Load8_BD(HX, RAX, offsetof(cpu_6502, x));
+    Load8_BD(HY, RAX, offsetof(cpu_6502, y));
+    Load8_BD(HP, RAX, offsetof(cpu_6502, p));
+}
+
+/* Common exit: EDI = PC, ESI = cycles (not counting penalties) */
+static void Emit_Epilogue(void) {
+    Mov_RP(RAX, &cpu);
+    Store8_BD(HA, RAX, offsetof(cpu_6502, a));
+    Store8_BD(HX, RAX, offsetof(cpu_6502, x));
+    Store8_BD(HY, RAX, offsetof(cpu_6502, y));
+    Store8_BD(HP, RAX, offsetof(cpu_6502, p));
+    B(0x66); B(0x89); ModRM(2, RDI, RAX); D(offsetof(cpu_6502, pc));
+    Mov_RR(RAX, RSI);
+    B(0x03); B(0x04); B(0x24);          /* add eax, [rsp] */
+    B(0x48); B(0x83); B(0xC4); B(0x08); /* add rsp, 8 */
+    B(0x41); B(0x5F);                   /* pop r15 */
+    B(0x41); B(0x5E);                   /* pop r14 */
+    B(0x41); B(0x5D);                   /* pop r13 */
+    B(0x41); B(0x5C);                   /* pop r12 */
+    B(0x5D);                            /* pop rbp */
+    B(0x5B);                            /* pop rbx */
+    B(0xC3);                            /* ret */
+}
+
+static void Emit_Exits(void) {
+    u8 *epilogue = out;
+    u32 i;
+
+    Emit_Epilogue();
+    for (i = 0; i < exit_count; i++) {
+        Patch(exits[i].jump, out);
+        if (exits[i].invalidate) {
+            Mov_RR(RDI, RAX);
+            Call(Cpu_Invalidate_Code);
+        }
+        Mov_RI(RDI, exits[i].pc);
+        Mov_RI(RSI, exits[i].cycles);
+        Patch(Jmp(), epilogue);
+    }
+}
+
+static u8 Jit_Init(void) {
+    void *mem;
+    u32 i;
+
+    mem = mmap(0, ARENA_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == mem) return 0;
+    arena = out = mem;
+
+    for (i = 0; i < 256; i++) {
+        nz_flags[i] = (i & FLG_SIGN) | (i ? 0 : FLG_ZERO);
+    }
+    return 1;
+}
+
+/* Func: native_block Jit_Compile(const decoded_block *blk)
+ * Desc: Translates as much of a PRG ROM block as possible.  The
+ *       generated code stops in front of the first instruction it
+ *       can't handle, leaving it to the interpreter. */
+native_block Jit_Compile(const decoded_block *blk) {
+    u8 *entry;
+    u16 pc = blk->pc;
+    u32 cycles = 0;
+    u8 i, ended = 0;
+
+    if (blk->pc < ROM_BASE) return 0;
+    if (!arena && !Jit_Init()) return 0;
+    if (out + MAX_BLOCK_CODE > arena + ARENA_SIZE) return 0;
+    if (!Supported(&blk->ops[0])) return 0;
+
+    entry = out;
+    exit_count = 0;
+    overflow = 0;
+
+    Emit_Prologue();
+    for (i = 0; i < blk->count && !ended; i++) {
+        if (!Supported(&blk->ops[i])) break;
+        ended = Emit_Insn(&blk->ops[i], pc, cycles);
+        pc += blk->ops[i].length;
+        cycles += op_cycles[blk->ops[i].opcode];
+    }
+    if (!ended) Add_Exit(Jmp(), pc, cycles, 0);
+    if (overflow) {
+        out = entry;
+        return 0;
+    }
+    Emit_Exits();
+    return (native_block)entry;
+}
+
+/* Func: void Jit_Reset(void)
+ * Desc: Reclaims the whole code buffer. */
+void Jit_Reset(void) {
+    out = arena;
+}
+
+#endif /* #ifdef USE_JIT */
@@ -0,0 +1,613 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: cpu-lanes.c
+ *
+ * Description:
+ *
+ *      Lockstep CPU core over CPU_LANES instances (see cpu-lanes.h).
+ *      Each step decodes the instruction at the PC of the lane that is
+ *      furthest behind, and executes it for every lane at that PC.
+ *      Register updates are computed for all lanes and selected by the
+ *      lane mask, so that the loops have no branches and may vectorize;
+ *      memory accesses are per lane (gathers and scatters).  Semantics
+ *      and cycle counts are those of the threaded core.  Experimental,
+ *      and no faster than the scalar core yet (see cpu-lanes.h).
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#include "cpu.h"
+#include "mem.h"
+#include "cart.h"
+#include "ppu.h"
+#include "opcode.h"
+#include "bitwise.h"
+#include "cpu-lanes.h"
+#include <string.h>
+
+#ifdef USE_LANES
+
+extern cpu_6502 cpu;
+
+/* From opcode.c */
+extern const u8 op_mode[];
+extern const u8 mode_length[];
+
+#define STACK_PAGE      0x0100
+#define RAM_END         0x2000
+#define ROM_BASE        0x8000
+
+/* Instructions, in the order OPCODE_LIST names them */
+enum {
+    I_ADC, I_AND, I_ASL, I_BCC, I_BCS, I_BEQ, I_BIT, I_BMI, I_BNE, I_BPL,
+    I_BRK, I_BVC, I_BVS, I_CLC, I_CLD, I_CLI, I_CLV, I_CMP, I_CPX, I_CPY,
+    I_DEC, I_DEX, I_DEY, I_EOR, I_INC, I_INX, I_INY, I_JMP, I_JSR, I_LDA,
+    I_LDX, I_LDY, I_LSR, I_NOP, I_ORA, I_PHA, I_PHP, I_PLA, I_PLP, I_ROL,
+    I_ROR, I_RTI, I_RTS, I_SBC, I_SEC, I_SED, I_SEI, I_STA, I_STX, I_STY,
+    I_TAX, I_TAY, I_TSX, I_TXA, I_TXS, I_TYA, I_UNS
+};
+
+#define OP(code, name, mode, cycles) I_##name,
+static const u8 op_insn[] = {
+    OPCODE_LIST(OP)
+};
+#undef OP
+
+#define OP(code, name, mode, cycles) cycles,
+static const u8 op_cycles[] = {
+    OPCODE_LIST(OP)
+};
+#undef OP
+
+/* How an instruction uses its memory operand */
+#define USE_NONE    0
+#define USE_READ    1       /* Pays the page crossing penalty */
+#define USE_WRITE   2
+#define USE_RMW     3
+
+static u8 Operand_Use(u8 insn) {
+    switch (insn) {
+        case I_ADC: case I_AND: case I_BIT: case I_CMP: case I_CPX:
+        case I_CPY: case I_EOR: case I_LDA: case I_LDX: case I_LDY:
+        case I_ORA: case I_SBC:
+            return USE_READ;
+        case I_STA: case I_STX: case I_STY:
+            return USE_WRITE;
+        case I_ASL: case I_LSR: case I_ROL: case I_ROR: case I_INC:
+        case I_DEC:
+            return USE_RMW;
+        default:
+            return USE_NONE;
+    }
+}
+
+#define EACH_LANE(l) for (l = 0; l < CPU_LANES; l++)
+
+/* Register update of the lanes in the step */
+#define SEL(dst, val)   (dst) = m[l] ? (val) : (dst)
+
+#define NZ_OF(p, r)                                                    \
+    (((p) & ~(FLG_SIGN | FLG_ZERO)) | ((r) & FLG_SIGN) | ((r) ? 0 : FLG_ZERO))
+
+/* Only internal RAM and PRG ROM exist for a lane; anything else stops
+ * it (see Lanes_Exec).  PRG ROM is read through the lane's copy of the
+ * CPU page table, in which pages the mapper has to see are 0. */
+#define LANE_ROM(ln, addr, l)                                          \
+    ((ln)->rom[((addr) - ROM_BASE) >> MEM_PAGE_SHIFT][l])
+#define LANE_READ(ln, addr, l)                                         \
+    (((addr) < RAM_END) ? (ln)->ram[(addr) & (LANE_RAM_SIZE - 1)][l]   \
+                        : LANE_ROM(ln, addr, l)[(addr) & (MEM_PAGE_SIZE - 1)])
+#define READ_BLOCKED(ln, addr, l)                                      \
+    ((addr) >= RAM_END && ((addr) < ROM_BASE || !LANE_ROM(ln, addr, l)))
+#define WRITE_BLOCKED(addr) ((addr) >= RAM_END)
+
+#define PUSH(ln, l, val)                                               \
+    (ln)->ram[STACK_PAGE | (ln)->s[l]--][l] = (val)
+#define PULL(ln, l)     (ln)->ram[STACK_PAGE | ++(ln)->s[l]][l]
+
+static void Stop(cpu_lanes *ln, u8 *m, u8 l) {
+    m[l] = 0;
+    ln->state[l] = LANE_STOPPED;
+}
+
+/* Executes the instruction at the PC of leader for every lane in m
+ * (which are all at that PC). */
+static void Lanes_Step(cpu_lanes *ln, u8 *m, u8 leader) {
+    u16 ad[CPU_LANES];
+    u8 v[CPU_LANES], extra[CPU_LANES];
+    register u32 l;
+    register u16 pc = ln->pc[leader], next, operand = 0, target;
+    register u8 opcode, mode, length, insn, use, i;
+
+    if (READ_BLOCKED(ln, pc, leader)) {
+        Stop(ln, m, leader);
+        return;
+    }
+    opcode = LANE_READ(ln, pc, leader);
+    mode = op_mode[opcode];
+    length = mode_length[mode];
+    for (i = 1; i < length; i++) {
+        target = pc + i;
+        if (READ_BLOCKED(ln, target, leader)) {
+            Stop(ln, m, leader);
+            return;
+        }
+        operand |= LANE_READ(ln, target, leader) << ((i - 1) * 8);
+    }
+
+    /* Code in RAM may differ from lane to lane, and so may the banks
+     * that code in ROM is read from */
+    for (i = 0; i < length; i++) {
+        target = pc + i;
+        if (target < RAM_END) {
+            EACH_LANE(l) {
+                if (ln->ram[target & (LANE_RAM_SIZE - 1)][l] !=
+                    ln->ram[target & (LANE_RAM_SIZE - 1)][leader]) m[l] = 0;
+            }
+        } else {
+            EACH_LANE(l) {
+                if (LANE_ROM(ln, target, l) != LANE_ROM(ln, target, leader)) m[l] = 0;
+            }
+        }
+    }
+
+    insn = op_insn[opcode];
+    use = Operand_Use(insn);
+    next = pc + length;
+
+    /* Effective addresses, and whether indexing crossed a page */
+    switch (mode) {
+        case MODE_ZERO_PAGE:
+        case MODE_ABSOLUTE:
+            EACH_LANE(l) { ad[l] = operand; extra[l] = 0; }
+            break;
+        case MODE_ZERO_PAGE_X:
+            EACH_LANE(l) { ad[l] = (u8)(operand + ln->x[l]); extra[l] = 0; }
+            break;
+        case MODE_ZERO_PAGE_Y:
+            EACH_LANE(l) { ad[l] = (u8)(operand + ln->y[l]); extra[l] = 0; }
+            break;
+        case MODE_ABSOLUTE_X:
+            EACH_LANE(l) {
+                ad[l] = operand + ln->x[l];
+                extra[l] = PAGE_OF(ad[l]) != PAGE_OF(operand);
+            }
+            break;
+        case MODE_ABSOLUTE_Y:
+            EACH_LANE(l) {
+                ad[l] = operand + ln->y[l];
+                extra[l] = PAGE_OF(ad[l]) != PAGE_OF(operand);
+            }
+            break;
+        case MODE_INDEXED_INDIRECT:
+            EACH_LANE(l) {
+                i = operand + ln->x[l];
+                ad[l] = TO_U16(ln->ram[i][l], ln->ram[(u8)(i + 1)][l]);
+                extra[l] = 0;
+            }
+            break;
+        case MODE_INDIRECT_INDEXED:
+            EACH_LANE(l) {
+                ad[l] = TO_U16(ln->ram[(u8)operand][l],
+                               ln->ram[(u8)(operand + 1)][l]);
+                extra[l] = PAGE_OF(ad[l]) != PAGE_OF(ad[l] + ln->y[l]);
+                ad[l] += ln->y[l];
+            }
+            break;
+        default:
+            EACH_LANE(l) { ad[l] = 0; extra[l] = 0; }
+            break;
+    }
+    if (USE_READ != use) {
+        EACH_LANE(l) extra[l] = 0;
+    }
+
+    /* Lanes whose access isn't internal RAM or PRG ROM stop in front of
+     * the instruction */
+    if (USE_NONE != use && MODE_IMMEDIATE != mode && MODE_ACCUMULATOR != mode) {
+        EACH_LANE(l) {
+            if (m[l] && ((USE_READ == use) ? READ_BLOCKED(ln, ad[l], l)
+                                           : WRITE_BLOCKED(ad[l]))) {
+                Stop(ln, m, l);
+            }
+        }
+    }
+    if (I_JMP == insn && MODE_INDIRECT == mode) {
+        target = PAGE_OF(operand) | (u8)(operand + 1);
+        EACH_LANE(l) {
+            if (m[l] && (READ_BLOCKED(ln, operand, l) ||
+                         READ_BLOCKED(ln, target, l))) Stop(ln, m, l);
+        }
+    }
+
+    /* Operand value */
+    if (MODE_IMMEDIATE == mode) {
+        EACH_LANE(l) v[l] = (u8)operand;
+    } else if (MODE_ACCUMULATOR == mode) {
+        EACH_LANE(l) v[l] = ln->a[l];
+    } else if (USE_READ == use || USE_RMW == use) {
+        EACH_LANE(l) v[l] = m[l] ? LANE_READ(ln, ad[l], l) : 0;
+    }
+
+    switch (insn) {
+        case I_ADC:
+        case I_SBC:
+            EACH_LANE(l) {
+                u8 o = (I_SBC == insn) ? (u8)~v[l] : v[l];
+                u16 sum = ln->a[l] + o + (ln->p[l] & FLG_CARRY);
+                u8 r = (u8)sum;
+                u8 p = (ln->p[l] & ~(FLG_OVERFLOW | FLG_CARRY)) |
+                       ((ln->a[l] ^ r) & (o ^ r) & 0x80 ? FLG_OVERFLOW : 0) |
+                       (sum > 0xFF ? FLG_CARRY : 0);
+                SEL(ln->a[l], r);
+                SEL(ln->p[l], NZ_OF(p, r));
+            }
+            break;
+        case I_AND:
+            EACH_LANE(l) {
+                u8 r = ln->a[l] & v[l];
+                SEL(ln->a[l], r); SEL(ln->p[l], NZ_OF(ln->p[l], r));
+            }
+            break;
+        case I_ORA:
+            EACH_LANE(l) {
+                u8 r = ln->a[l] | v[l];
+                SEL(ln->a[l], r); SEL(ln->p[l], NZ_OF(ln->p[l], r));
+            }
+            break;
+        case I_EOR:
+            EACH_LANE(l) {
+                u8 r = ln->a[l] ^ v[l];
+                SEL(ln->a[l], r); SEL(ln->p[l], NZ_OF(ln->p[l], r));
+            }
+            break;
+        case I_LDA:
+            EACH_LANE(l) {
+                SEL(ln->a[l], v[l]); SEL(ln->p[l], NZ_OF(ln->p[l], v[l]));
+            }
+            break;
+        case I_LDX:
+            EACH_LANE(l) {
+                SEL(ln->x[l], v[l]); SEL(ln->p[l], NZ_OF(ln->p[l], v[l]));
+            }
+            break;
+        case I_LDY:
+            EACH_LANE(l) {
+                SEL(ln->y[l], v[l]); SEL(ln->p[l], NZ_OF(ln->p[l], v[l]));
+            }
+            break;
+        case I_CMP:
+        case I_CPX:
+        case I_CPY:
+            EACH_LANE(l) {
+                u8 reg = (I_CMP == insn) ? ln->a[l] :
+                         (I_CPX == insn) ? ln->x[l] : ln->y[l];
+                u8 r = reg - v[l];
+                u8 p = (ln->p[l] & ~FLG_CARRY) | (reg >= v[l] ? FLG_CARRY : 0);
+                SEL(ln->p[l], NZ_OF(p, r));
+            }
+            break;
+        case I_BIT:
+            EACH_LANE(l) {
+                u8 p = (ln->p[l] & ~(FLG_SIGN | FLG_OVERFLOW | FLG_ZERO)) |
+                       (v[l] & (FLG_SIGN | FLG_OVERFLOW)) |
+                       ((ln->a[l] & v[l]) ? 0 : FLG_ZERO);
+                SEL(ln->p[l], p);
+            }
+            break;
+
+        case I_ASL: case I_LSR: case I_ROL: case I_ROR:
+        case I_INC: case I_DEC:
+            EACH_LANE(l) {
+                u8 c = ln->p[l] & FLG_CARRY, r, nc;
+                switch (insn) {
+                    case I_ASL: r = v[l] << 1; nc = v[l] >> 7; break;
+                    case I_LSR: r = v[l] >> 1; nc = v[l] & 1; break;
+                    case I_ROL: r = (v[l] << 1) | c; nc = v[l] >> 7; break;
+                    case I_ROR: r = (v[l] >> 1) | (c << 7); nc = v[l] & 1; break;
+                    case I_INC: r = v[l] + 1; nc = c; break;
+                    default:    r = v[l] - 1; nc = c; break;
+                }
+                v[l] = r;
+                SEL(ln->p[l], NZ_OF((ln->p[l] & ~FLG_CARRY) | nc, r));
+            }
+            if (MODE_ACCUMULATOR == mode) {
+                EACH_LANE(l) SEL(ln->a[l], v[l]);
+            } else {
+                EACH_LANE(l) {
+                    if (m[l]) ln->ram[ad[l] & (LANE_RAM_SIZE - 1)][l] = v[l];
+                }
+            }
+            break;
+
+        case I_STA:
+            EACH_LANE(l) if (m[l]) ln->ram[ad[l] & (LANE_RAM_SIZE - 1)][l] = ln->a[l];
+            break;
+        case I_STX:
+            EACH_LANE(l) if (m[l]) ln->ram[ad[l] & (LANE_RAM_SIZE - 1)][l] = ln->x[l];
+            break;
+        case I_STY:
+            EACH_LANE(l) if (m[l]) ln->ram[ad[l] & (LANE_RAM_SIZE - 1)][l] = ln->y[l];
+            break;
+
+        case I_INX:
+            EACH_LANE(l) {
+                u8 r = ln->x[l] + 1;
+                SEL(ln->x[l], r); SEL(ln->p[l], NZ_OF(ln->p[l], r));
+            }
+            break;
+        case I_INY:
+            EACH_LANE(l) {
+                u8 r = ln->y[l] + 1;
+                SEL(ln->y[l], r); SEL(ln->p[l], NZ_OF(ln->p[l], r));
+            }
+            break;
+        case I_DEX:
+            EACH_LANE(l) {
+                u8 r = ln->x[l] - 1;
+                SEL(ln->x[l], r); SEL(ln->p[l], NZ_OF(ln->p[l], r));
+            }
+            break;
+        case I_DEY:
+            EACH_LANE(l) {
+                u8 r = ln->y[l] - 1;
+                SEL(ln->y[l], r); SEL(ln->p[l], NZ_OF(ln->p[l], r));
+            }
+            break;
+        case I_TAX:
+            EACH_LANE(l) {
+                SEL(ln->x[l], ln->a[l]); SEL(ln->p[l], NZ_OF(ln->p[l], ln->a[l]));
+            }
+            break;
+        case I_TAY:
+            EACH_LANE(l) {
+                SEL(ln->y[l], ln->a[l]); SEL(ln->p[l], NZ_OF(ln->p[l], ln->a[l]));
+            }
+            break;
+        case I_TSX:
+            EACH_LANE(l) {
+                SEL(ln->x[l], ln->s[l]); SEL(ln->p[l], NZ_OF(ln->p[l], ln->s[l]));
+            }
+            break;
+        case I_TXA:
+            EACH_LANE(l) {
+                SEL(ln->a[l], ln->x[l]); SEL(ln->p[l], NZ_OF(ln->p[l], ln->x[l]));
+            }
+            break;
+        case I_TYA:
+            EACH_LANE(l) {
+                SEL(ln->a[l], ln->y[l]); SEL(ln->p[l], NZ_OF(ln->p[l], ln->y[l]));
+            }
+            break;
+        case I_TXS:
+            EACH_LANE(l) SEL(ln->s[l], ln->x[l]);
+            break;
+
+        case I_CLC: EACH_LANE(l) SEL(ln->p[l], ln->p[l] & ~FLG_CARRY); break;
+        case I_SEC: EACH_LANE(l) SEL(ln->p[l], ln->p[l] | FLG_CARRY); break;
+        case I_CLD: EACH_LANE(l) SEL(ln->p[l], ln->p[l] & ~FLG_DECIMAL); break;
+        case I_SED: EACH_LANE(l) SEL(ln->p[l], ln->p[l] | FLG_DECIMAL); break;
+        case I_CLI: EACH_LANE(l) SEL(ln->p[l], ln->p[l] & ~FLG_INT_DIS); break;
+        case I_SEI: EACH_LANE(l) SEL(ln->p[l], ln->p[l] | FLG_INT_DIS); break;
+        case I_CLV: EACH_LANE(l) SEL(ln->p[l], ln->p[l] & ~FLG_OVERFLOW); break;
+
+        case I_PHA:
+            EACH_LANE(l) if (m[l]) PUSH(ln, l, ln->a[l]);
+            break;
+        case I_PHP:
+            EACH_LANE(l) if (m[l]) PUSH(ln, l, ln->p[l] | FLG_BRK);
+            break;
+        case I_PLA:
+            EACH_LANE(l) {
+                if (!m[l]) continue;
+                ln->a[l] = PULL(ln, l);
+                ln->p[l] = NZ_OF(ln->p[l], ln->a[l]);
+            }
+            break;
+        case I_PLP:
+            EACH_LANE(l) {
+                if (m[l]) ln->p[l] = (PULL(ln, l) & ~FLG_BRK) | FLG_NOT_USED;
+            }
+            break;
+
+        /* Control flow sets PC itself */
+        case I_BCC: case I_BCS: case I_BEQ: case I_BNE:
+        case I_BMI: case I_BPL: case I_BVC: case I_BVS:
+            target = next + (i8)operand;
+            EACH_LANE(l) {
+                u8 p = ln->p[l], taken;
+                switch (insn) {
+                    case I_BCC: taken = !(p & FLG_CARRY); break;
+                    case I_BCS: taken = !!(p & FLG_CARRY); break;
+                    case I_BEQ: taken = !!(p & FLG_ZERO); break;
+                    case I_BNE: taken = !(p & FLG_ZERO); break;
+                    case I_BMI: taken = !!(p & FLG_SIGN); break;
+                    case I_BPL: taken = !(p & FLG_SIGN); break;
+                    case I_BVS: taken = !!(p & FLG_OVERFLOW); break;
+                    default:    taken = !(p & FLG_OVERFLOW); break;
+                }
+                extra[l] = taken ? ((PAGE_OF(next) == PAGE_OF(target)) ? 1 : 2) : 0;
+                SEL(ln->pc[l], taken ? target : next);
+            }
+            goto cycles;
+        case I_JMP:
+            if (MODE_INDIRECT == mode) {
+                target = PAGE_OF(operand) | (u8)(operand + 1);
+                EACH_LANE(l) {
+                    if (!m[l]) continue;
+                    ln->pc[l] = TO_U16(LANE_READ(ln, operand, l),
+                                       LANE_READ(ln, target, l));
+                }
+            } else {
+                EACH_LANE(l) SEL(ln->pc[l], operand);
+            }
+            goto cycles;
+        case I_JSR:
+            EACH_LANE(l) {
+                if (!m[l]) continue;
+                PUSH(ln, l, (u8)((u16)(next - 1) >> 8));
+                PUSH(ln, l, (u8)(next - 1));
+                ln->pc[l] = operand;
+            }
+            goto cycles;
+        case I_RTS:
+            EACH_LANE(l) {
+                if (!m[l]) continue;
+                ad[l] = PULL(ln, l);
+                ad[l] |= PULL(ln, l) << 8;
+                ln->pc[l] = ad[l] + 1;
+            }
+            goto cycles;
+        case I_RTI:
+            EACH_LANE(l) {
+                if (!m[l]) continue;
+                ln->p[l] = PULL(ln, l) | FLG_NOT_USED;
+                ad[l] = PULL(ln, l);
+                ad[l] |= PULL(ln, l) << 8;
+                ln->pc[l] = ad[l];
+            }
+            goto cycles;
+        case I_BRK:
+            EACH_LANE(l) {
+                if (!m[l]) continue;
+                if (READ_BLOCKED(ln, 0xFFFE, l)) {
+                    Stop(ln, m, l);
+                    continue;
+                }
+                PUSH(ln, l, (u8)(next >> 8));
+                PUSH(ln, l, (u8)next);
+                PUSH(ln, l, ln->p[l]);
+                ln->p[l] |= FLG_BRK;
+                ln->pc[l] = TO_U16(LANE_READ(ln, 0xFFFE, l),
+                                   LANE_READ(ln, 0xFFFF, l));
+            }
+            goto cycles;
+
+        default:    /* NOP, UNS */
+            break;
+    }
+    EACH_LANE(l) SEL(ln->pc[l], next);
+
+cycles:
+    EACH_LANE(l) SEL(ln->cycles[l], ln->cycles[l] + op_cycles[opcode] + extra[l]);
+}
+
+/* Func: u32 Lanes_Exec(cpu_lanes *lanes, u32 cycles)
+ * Desc: Runs whole instructions on every running lane until at least
+ *       the given number of cycles have elapsed for it, or it stops in
+ *       front of an access only the scalar emulator can make, or at
+ *       its next event.  Returns a mask of the stopped lanes. */
+u32 Lanes_Exec(cpu_lanes *ln, u32 cycles) {
+    u64 start[CPU_LANES];
+    u32 best;
+    u8 m[CPU_LANES], live[CPU_LANES];
+    register u32 l, leader, stopped = 0;
+    register u16 pc;
+
+    EACH_LANE(l) start[l] = ln->cycles[l];
+    for (;;) {
+        /* The lane furthest behind leads */
+        leader = CPU_LANES;
+        best = cycles;
+        EACH_LANE(l) {
+            if (LANE_RUNNING == ln->state[l] && ln->cycles[l] >= ln->next[l]) {
+                ln->state[l] = LANE_STOPPED;
+            }
+            live[l] = (LANE_RUNNING == ln->state[l]) &&
+                      (ln->cycles[l] - start[l] < cycles);
+            if (live[l] && ln->cycles[l] - start[l] < best) {
+                best = ln->cycles[l] - start[l];
+                leader = l;
+            }
+        }
+        if (CPU_LANES == leader) break;
+
+        pc = ln->pc[leader];
+        EACH_LANE(l) m[l] = (live[l] && pc == ln->pc[l]) ? 0xFF : 0;
+        Lanes_Step(ln, m, leader);
+    }
+
+    EACH_LANE(l) {
+        if (LANE_STOPPED == ln->state[l]) stopped |= 1 << l;
+    }
+    return stopped;
+}
+
+/* Func: void Lanes_Init(cpu_lanes *lanes)
+ * Desc: Starts every lane from the scalar emulator. */
+void Lanes_Init(cpu_lanes *ln) {
+    register u32 l;
+
+    EACH_LANE(l) Lanes_Store(ln, l);
+}
+
+/* Func: void Lanes_Load(const cpu_lanes *lanes, u8 lane)
+ * Desc: Puts a lane into the scalar emulator, e.g. to let Cpu_Step make
+ *       an access the lane stopped in front of.  A lane that ran into
+ *       its next event has it fired here, and any interrupt it raises
+ *       taken, as Cpu_Step would have after the instruction. */
+void Lanes_Load(const cpu_lanes *ln, u8 lane) {
+    u8 buf[LANE_RAM_SIZE];
+    register u16 i;
+
+    cpu.a = ln->a[lane];
+    cpu.x = ln->x[lane];
+    cpu.y = ln->y[lane];
+    cpu.p = ln->p[lane];
+    cpu.s = ln->s[lane];
+    cpu.pc = ln->pc[lane];
+    cpu.pending = ln->pending[lane];
+    cpu.irq = ln->irq[lane];
+    cpu.cycles = ln->cycles[lane];
+    for (i = 0; i < LANE_RAM_SIZE; i++) buf[i] = ln->ram[i][lane];
+    Mem_Write_Block(0, buf, LANE_RAM_SIZE);
+
+    /* The cartridge first: the PPU schedules the mapper's IRQ */
+    Load_Cartridge_State(ln->cart[lane]);
+    ppu = ln->ppu[lane];
+    Ppu_Restore();
+
+    /* Lanes with an interrupt waiting never ran (see Lanes_Store) */
+    if (!(ln->pending[lane] & CPU_PENDING_NMI) && !ln->irq[lane] &&
+        cpu.cycles >= ln->next[lane]) {
+        if (cpu.cycles >= sched_next) Sched_Run(cpu.cycles);
+        Cpu_Take_Interrupts();
+    }
+}
+
+/* Func: void Lanes_Store(cpu_lanes *lanes, u8 lane)
+ * Desc: Takes the scalar emulator back into a lane, which then runs
+ *       again up to the emulator's next event.  One with an interrupt
+ *       waiting is left to the scalar emulator. */
+void Lanes_Store(cpu_lanes *ln, u8 lane) {
+    u8 buf[LANE_RAM_SIZE];
+    register u16 i;
+
+    Ppu_Sync();
+    ln->a[lane] = cpu.a;
+    ln->x[lane] = cpu.x;
+    ln->y[lane] = cpu.y;
+    ln->p[lane] = cpu.p;
+    ln->s[lane] = cpu.s;
+    ln->pc[lane] = cpu.pc;
+    ln->pending[lane] = cpu.pending;
+    ln->irq[lane] = cpu.irq;
+    ln->cycles[lane] = cpu.cycles;
+    ln->next[lane] = ((cpu.pending & CPU_PENDING_NMI) || cpu.irq) ? cpu.cycles
+                                                                  : sched_next;
+    ln->state[lane] = LANE_RUNNING;
+    Mem_Read_Block(buf, 0, LANE_RAM_SIZE);
+    for (i = 0; i < LANE_RAM_SIZE; i++) ln->ram[i][lane] = buf[i];
+    for (i = 0; i < LANE_ROM_PAGES; i++) {
+        ln->rom[i][lane] = Mem_Get_Page(ROM_BASE + (i << MEM_PAGE_SHIFT));
+    }
+
+    ln->ppu[lane] = ppu;
+    Save_Cartridge_State(ln->cart[lane]);
+}
+
+#endif /* #ifdef USE_LANES */
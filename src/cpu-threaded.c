@@ -0,0 +1,1149 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: cpu-threaded.c
+ *
+ * Description:
+ *
+ *      Threaded-dispatch CPU core.  Every entry of OPCODE_LIST is
+ *      expanded into its own handler, with the addressing mode, the
+ *      page-crossing penalty and the base cycle count fused in at
+ *      compile time.  Handlers jump straight to the next handler
+ *      (computed goto) when USE_COMPUTED_GOTO is defined, and fall back
+ *      to a plain switch otherwise.
+ *
+ *      The semantics here must stay identical to the reference
+ *      interpreter in opcode.c (Dispatch_Opcode), which is still used
+ *      for single-stepping in the debugger.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#include "cpu.h"
+#include "mem.h"
+#include "opcode.h"
+#include "bitwise.h"
+#include "ppu.h"
+#include "sched.h"
+#include "cpu-block.h"
+#include "cpu-jit.h"
+#include "cpu-aot.h"
+#include <stdio.h>
+#include <string.h>
+
+extern cpu_6502 cpu;
+extern ppu_2c02 ppu;
+
+/* The registers live in locals of Cpu_Exec for the whole time slice,
+ * so the compiler can keep them in host registers across calls.  cpu is
+ * only brought up to date (SYNC_REGS) before I/O accesses, interrupts,
+ * native blocks and on return, and reread (LOAD_REGS) after anything
+ * that may have changed it. */
+#define A  reg_a
+#define X  reg_x
+#define Y  reg_y
+#define S  reg_s
+#define P  reg_p
+#define PC reg_pc
+
+#define STACK_PAGE 0x0100
+
+/* Flag helpers.  With USE_LAZY_FLAGS, N, Z, C and V are not kept in P
+ * while Cpu_Exec runs: N is bit 7 of flag_n, Z is set when flag_z is 0,
+ * and C and V are set when flag_c and flag_v are non-zero.  Every flag
+ * update then becomes a plain store rather than a read-modify-write of
+ * P.  SYNC_FLAGS() folds them back into P wherever P is observed (PHP,
+ * BRK, interrupts, native blocks, and on return, so the debugger and
+ * anything else outside the core always see a real P); LOAD_FLAGS()
+ * picks them up again wherever P is written as a whole. */
+#define SET(flags) FLAG_SET(P, flags)
+#define CLR(flags) FLAG_CLEAR(P, flags)
+
+/* An asserted IRQ is taken (at the next pending check) once I is clear */
+#define CHECK_IRQ() if (cpu.irq) cpu.pending |= CPU_PENDING_IRQ
+#ifdef USE_LAZY_FLAGS
+#define SET_NZ(val) flag_n = flag_z = (val)
+#define SET_N_Z(n, z) flag_n = (n); flag_z = (z)
+#define SET_C(cond) flag_c = ((cond) != 0)
+#define SET_V(cond) flag_v = ((cond) != 0)
+#define IS_N()      (flag_n & FLG_SIGN)
+#define IS_Z()      (!flag_z)
+#define IS_C()      (flag_c)
+#define IS_V()      (flag_v)
+#define SYNC_FLAGS()                                                   \
+    P = (P & ~(FLG_SIGN | FLG_OVERFLOW | FLG_ZERO | FLG_CARRY))        \
+      | (flag_n & FLG_SIGN) | (flag_v ? FLG_OVERFLOW : 0)              \
+      | ((!flag_z) << 1) | flag_c
+#define LOAD_FLAGS()                                                   \
+    flag_n = P; flag_z = !(P & FLG_ZERO);                              \
+    flag_c = P & FLG_CARRY; flag_v = P & FLG_OVERFLOW
+#else
+#define SET_NZ(val) SET_N_Z(val, val)
+#define SET_N_Z(n, z) \
+    P = (P & ~(FLG_SIGN | FLG_ZERO)) | ((n) & FLG_SIGN) | ((!(z)) << 1)
+#define SET_C(cond) FLAG_COND(cond, P, FLG_CARRY)
+#define SET_V(cond) FLAG_COND(cond, P, FLG_OVERFLOW)
+#define IS_N()      (P & FLG_SIGN)
+#define IS_Z()      (P & FLG_ZERO)
+#define IS_C()      (P & FLG_CARRY)
+#define IS_V()      (P & FLG_OVERFLOW)
+#define SYNC_FLAGS() ((void)0)
+#define LOAD_FLAGS() ((void)0)
+#endif /* #ifdef USE_LAZY_FLAGS */
+
+#define SYNC_REGS()                                                    \
+    (SYNC_FLAGS(), cpu.a = A, cpu.x = X, cpu.y = Y, cpu.s = S,         \
+     cpu.p = P, cpu.pc = PC)
+#define LOAD_REGS()                                                    \
+    A = cpu.a; X = cpu.x; Y = cpu.y; S = cpu.s; P = cpu.p; PC = cpu.pc; \
+    LOAD_FLAGS()
+
+/* Memory access.  Only $2000-$5FFF (PPU, APU, joypads, expansion) may
+ * do more than hold a byte, so that is the only range the registers are
+ * synced for.  Zero page, zero page pointers and the stack are always
+ * internal RAM and skip the memory map altogether. */
+#define IS_IO(addr) ((u16)((addr) - 0x2000) < 0x4000)
+#define READ(addr)                                                     \
+    (IS_IO(addr) ? (SYNC_REGS(), Mem_Fetch(addr)) : Mem_Fetch(addr))
+#define WRITE(addr, val)                                               \
+    do {                                                               \
+        if (IS_IO(addr)) SYNC_REGS();                                  \
+        Mem_Set(addr, val);                                            \
+    } while (0)
+
+#define PUSH(val) MEM_SET_RAM(STACK_PAGE | S--, (val))
+#define PULL()    MEM_FETCH_RAM(STACK_PAGE | ++S)
+
+/* Page crossing check for indexed modes; evaluates to 1 or 0. */
+#define CROSSES(base, index) (PAGE_OF(base) != PAGE_OF((base) + (index)))
+
+#define FETCH_BYTE() Mem_Fetch(PC++)
+#define FETCH16(dst) \
+    dst = FETCH_BYTE(); dst |= (u16)FETCH_BYTE() << 8
+
+/* Operand fetch, per addressing mode.  This is the prologue of every
+ * handler when running straight from memory; decoded blocks already
+ * hold the operand and skip it. */
+#define FETCH_MODE_IMPLICIT
+#define FETCH_MODE_ACCUMULATOR
+#define FETCH_MODE_IMMEDIATE          operand = FETCH_BYTE()
+#define FETCH_MODE_ZERO_PAGE          operand = FETCH_BYTE()
+#define FETCH_MODE_ZERO_PAGE_X        operand = FETCH_BYTE()
+#define FETCH_MODE_ZERO_PAGE_Y        operand = FETCH_BYTE()
+#define FETCH_MODE_RELATIVE           operand = FETCH_BYTE()
+#define FETCH_MODE_ABSOLUTE           FETCH16(operand)
+#define FETCH_MODE_ABSOLUTE_X         FETCH16(operand)
+#define FETCH_MODE_ABSOLUTE_Y         FETCH16(operand)
+#define FETCH_MODE_INDIRECT           FETCH16(operand)
+#define FETCH_MODE_INDEXED_INDIRECT   operand = FETCH_BYTE()
+#define FETCH_MODE_INDIRECT_INDEXED   operand = FETCH_BYTE()
+
+/* Effective address computation, per addressing mode.  These never add
+ * the page crossing penalty; they are used by stores, read-modify-write
+ * instructions and jumps, whose cycle counts are fixed. */
+#define ADDR_MODE_ZERO_PAGE         addr = (u8)operand
+#define ADDR_MODE_ZERO_PAGE_X       addr = (u8)(operand + X)
+#define ADDR_MODE_ZERO_PAGE_Y       addr = (u8)(operand + Y)
+#define ADDR_MODE_ABSOLUTE          addr = operand
+#define ADDR_MODE_ABSOLUTE_X        addr = operand + X
+#define ADDR_MODE_ABSOLUTE_Y        addr = operand + Y
+#define ADDR_MODE_INDEXED_INDIRECT                                     \
+    v = operand + X;                                                   \
+    addr = TO_U16(MEM_FETCH_RAM(v), MEM_FETCH_RAM((u8)(v + 1)))
+#define ADDR_MODE_INDIRECT_INDEXED                                     \
+    v = operand;                                                       \
+    addr = TO_U16(MEM_FETCH_RAM(v), MEM_FETCH_RAM((u8)(v + 1))) + Y
+/* JMP ($xxFF) wraps within the page when fetching the high byte. */
+#define ADDR_MODE_INDIRECT                                             \
+    v = READ(operand);                                                 \
+    addr = TO_U16(v, READ(PAGE_OF(operand) | (u8)(operand + 1)))
+
+/* Operand value fetch, per addressing mode.  Indexed modes add the
+ * extra cycle on page crossing. */
+#define READ_MODE_IMMEDIATE         v = (u8)operand
+#define READ_MODE_ZERO_PAGE         ADDR_MODE_ZERO_PAGE; v = MEM_FETCH_RAM(addr)
+#define READ_MODE_ZERO_PAGE_X       ADDR_MODE_ZERO_PAGE_X; v = MEM_FETCH_RAM(addr)
+#define READ_MODE_ZERO_PAGE_Y       ADDR_MODE_ZERO_PAGE_Y; v = MEM_FETCH_RAM(addr)
+#define READ_MODE_ABSOLUTE          ADDR_MODE_ABSOLUTE; v = READ(addr)
+#define READ_MODE_ABSOLUTE_X                                           \
+    extra += CROSSES(operand, X); ADDR_MODE_ABSOLUTE_X; v = READ(addr)
+#define READ_MODE_ABSOLUTE_Y                                           \
+    extra += CROSSES(operand, Y); ADDR_MODE_ABSOLUTE_Y; v = READ(addr)
+#define READ_MODE_INDEXED_INDIRECT  ADDR_MODE_INDEXED_INDIRECT; v = READ(addr)
+#define READ_MODE_INDIRECT_INDEXED                                     \
+    v = operand;                                                       \
+    addr = TO_U16(MEM_FETCH_RAM(v), MEM_FETCH_RAM((u8)(v + 1)));       \
+    extra += CROSSES(addr, Y);                                         \
+    addr += Y; v = READ(addr)
+
+/* Read-modify-write operand access.  Accumulator mode never touches
+ * memory. */
+#define RMW_LOAD_MODE_ACCUMULATOR   v = A
+#define RMW_LOAD_MODE_ZERO_PAGE     READ_MODE_ZERO_PAGE
+#define RMW_LOAD_MODE_ZERO_PAGE_X   READ_MODE_ZERO_PAGE_X
+#define RMW_LOAD_MODE_ABSOLUTE      READ_MODE_ABSOLUTE
+#define RMW_LOAD_MODE_ABSOLUTE_X    ADDR_MODE_ABSOLUTE_X; v = READ(addr)
+
+#define RMW_STORE_MODE_ACCUMULATOR  A = v
+#define RMW_STORE_MODE_ZERO_PAGE    STORE_MODE_ZERO_PAGE(v)
+#define RMW_STORE_MODE_ZERO_PAGE_X  STORE_MODE_ZERO_PAGE_X(v)
+#define RMW_STORE_MODE_ABSOLUTE     STORE_MODE_ABSOLUTE(v)
+#define RMW_STORE_MODE_ABSOLUTE_X   STORE_MODE_ABSOLUTE_X(v)
+
+/* Store to the effective address, per addressing mode */
+#define STORE_MODE_ZERO_PAGE(val)         MEM_SET_RAM(addr, val)
+#define STORE_MODE_ZERO_PAGE_X(val)       MEM_SET_RAM(addr, val)
+#define STORE_MODE_ZERO_PAGE_Y(val)       MEM_SET_RAM(addr, val)
+#define STORE_MODE_ABSOLUTE(val)          WRITE(addr, val)
+#define STORE_MODE_ABSOLUTE_X(val)        WRITE(addr, val)
+#define STORE_MODE_ABSOLUTE_Y(val)        WRITE(addr, val)
+#define STORE_MODE_INDEXED_INDIRECT(val)  WRITE(addr, val)
+#define STORE_MODE_INDIRECT_INDEXED(val)  WRITE(addr, val)
+
+/* Add with carry; shared by ADC and SBC. */
+#define ADD(op) {                                                      \
+    register u16 s = (u16)A + (u16)(op) + (u16)IS_C();                 \
+    SET_V((A ^ s) & ((op) ^ s) & 0x80);                                \
+    SET_C(s > 0xFF);                                                   \
+    A = (u8)s;                                                         \
+    SET_NZ(A);                                                         \
+}
+
+/* Compare; like a subtraction that only updates C, Z and N. */
+#define COMPARE(reg) {                                                 \
+    register u8 r = (reg) - v;                                         \
+    SET_C((reg) >= v);                                                 \
+    SET_NZ(r);                                                         \
+}
+
+/* Branches cost one extra cycle when taken, two if that crosses a
+ * page. */
+#define BRANCH(cond)                                                   \
+    if (cond) {                                                        \
+        addr = PC + (i8)operand;                                       \
+        extra += (PAGE_OF(PC) == PAGE_OF(addr)) ? 1 : 2;               \
+        PC = addr;                                                     \
+    }
+
+/* Instruction semantics.  m is the (expanded) addressing mode. */
+#define EXEC_ADC(m) READ_##m; ADD(v)
+#define EXEC_AND(m) READ_##m; A &= v; SET_NZ(A)
+#define EXEC_ASL(m)                                                    \
+    RMW_LOAD_##m; SET_C(v & FLG_SIGN); v <<= 1; SET_NZ(v);             \
+    RMW_STORE_##m
+#define EXEC_BCC(m) BRANCH(!IS_C())
+#define EXEC_BCS(m) BRANCH(IS_C())
+#define EXEC_BEQ(m) BRANCH(IS_Z())
+#define EXEC_BIT(m)                                                    \
+    READ_##m;                                                          \
+    SET_V(v & FLG_OVERFLOW);                                           \
+    SET_N_Z(v, A & v)
+#define EXEC_BMI(m) BRANCH(IS_N())
+#define EXEC_BNE(m) BRANCH(!IS_Z())
+#define EXEC_BPL(m) BRANCH(!IS_N())
+#define EXEC_BRK(m)                                                    \
+    SYNC_FLAGS();                                                      \
+    PUSH((u8)(PC >> 8)); PUSH((u8)(PC & 0xFF)); PUSH(P);               \
+    SET(FLG_BRK);                                                      \
+    PC = Mem_Fetch16(0xFFFE)
+#define EXEC_BVC(m) BRANCH(!IS_V())
+#define EXEC_BVS(m) BRANCH(IS_V())
+#define EXEC_CLC(m) SET_C(0)
+#define EXEC_CLD(m) CLR(FLG_DECIMAL)
+#define EXEC_CLI(m) CLR(FLG_INT_DIS); CHECK_IRQ()
+#define EXEC_CLV(m) SET_V(0)
+#define EXEC_CMP(m) READ_##m; COMPARE(A)
+#define EXEC_CPX(m) READ_##m; COMPARE(X)
+#define EXEC_CPY(m) READ_##m; COMPARE(Y)
+#define EXEC_DEC(m) RMW_LOAD_##m; --v; SET_NZ(v); RMW_STORE_##m
+#define EXEC_DEX(m) --X; SET_NZ(X)
+#define EXEC_DEY(m) --Y; SET_NZ(Y)
+#define EXEC_EOR(m) READ_##m; A ^= v; SET_NZ(A)
+#define EXEC_INC(m) RMW_LOAD_##m; ++v; SET_NZ(v); RMW_STORE_##m
+#define EXEC_INX(m) ++X; SET_NZ(X)
+#define EXEC_INY(m) ++Y; SET_NZ(Y)
+#define EXEC_JMP(m) ADDR_##m; PC = addr
+#define EXEC_JSR(m)                                                    \
+    ADDR_##m;                                                          \
+    PUSH((u8)((PC - 1) >> 8)); PUSH((u8)((PC - 1) & 0xFF));            \
+    PC = addr
+#define EXEC_LDA(m) READ_##m; A = v; SET_NZ(A)
+#define EXEC_LDX(m) READ_##m; X = v; SET_NZ(X)
+#define EXEC_LDY(m) READ_##m; Y = v; SET_NZ(Y)
+#define EXEC_LSR(m)                                                    \
+    RMW_LOAD_##m; SET_C(v & FLG_CARRY); v >>= 1; SET_NZ(v);            \
+    RMW_STORE_##m
+#define EXEC_NOP(m)
+#define EXEC_ORA(m) READ_##m; A |= v; SET_NZ(A)
+#define EXEC_PHA(m) PUSH(A)
+#define EXEC_PHP(m) SYNC_FLAGS(); PUSH(P | FLG_BRK)
+#define EXEC_PLA(m) A = PULL(); SET_NZ(A)
+#define EXEC_PLP(m)                                                    \
+    P = (PULL() & ~FLG_BRK) | FLG_NOT_USED; LOAD_FLAGS(); CHECK_IRQ()
+#define EXEC_ROL(m)                                                    \
+    RMW_LOAD_##m; c = IS_C() ? 0x01 : 0;                               \
+    SET_C(v & FLG_SIGN); v = (v << 1) | c; SET_NZ(v);                  \
+    RMW_STORE_##m
+#define EXEC_ROR(m)                                                    \
+    RMW_LOAD_##m; c = IS_C() ? 0x80 : 0;                               \
+    SET_C(v & FLG_CARRY); v = (v >> 1) | c; SET_NZ(v);                 \
+    RMW_STORE_##m
+#define EXEC_RTI(m)                                                    \
+    P = PULL() | FLG_NOT_USED; LOAD_FLAGS();                           \
+    addr = PULL(); addr |= (u16)PULL() << 8;                           \
+    PC = addr; CHECK_IRQ()
+#define EXEC_RTS(m)                                                    \
+    addr = PULL(); addr |= (u16)PULL() << 8;                           \
+    PC = addr + 1
+#define EXEC_SBC(m) READ_##m; v = ~v; ADD(v)
+#define EXEC_SEC(m) SET_C(1)
+#define EXEC_SED(m) SET(FLG_DECIMAL)
+#define EXEC_SEI(m) SET(FLG_INT_DIS)
+#define EXEC_STA(m) ADDR_##m; STORE_##m(A)
+#define EXEC_STX(m) ADDR_##m; STORE_##m(X)
+#define EXEC_STY(m) ADDR_##m; STORE_##m(Y)
+#define EXEC_TAX(m) X = A; SET_NZ(X)
+#define EXEC_TAY(m) Y = A; SET_NZ(Y)
+#define EXEC_TSX(m) X = S; SET_NZ(X)
+#define EXEC_TXA(m) A = X; SET_NZ(A)
+#define EXEC_TXS(m) S = X
+#define EXEC_TYA(m) A = Y; SET_NZ(A)
+#define EXEC_UNS(m)
+
+/* Block cache.  Straight-line runs of code in PRG ROM and internal RAM
+ * are decoded once into a block of pre-resolved handlers, operands and
+ * lengths, so that running them again skips the opcode fetch and the
+ * operand fetches entirely.  A block ends at the first instruction that
+ * changes control flow.  Blocks are keyed by PC for ROM and by physical
+ * address for RAM; RAM blocks are dropped when the bytes they were
+ * decoded from are written (see Cpu_Invalidate_Code), ROM blocks are
+ * ignored once the mapper switched their PRG bank out (see Find_Block). */
+#define BLOCK_POOL_SIZE  2048
+
+#define ROM_BLOCK_BASE   0x8000
+#define ROM_BLOCK_SLOTS  0x8000
+#define RAM_BLOCK_SLOTS  0x0800
+#define RAM_BLOCK_END    0x2000
+
+static decoded_block block_pool[BLOCK_POOL_SIZE];
+static u32 block_count;
+
+static decoded_block *rom_blocks[ROM_BLOCK_SLOTS];
+static decoded_block *ram_blocks[RAM_BLOCK_SLOTS];
+
+#ifdef USE_JIT
+/* Run hot PRG ROM blocks as native code (see Cpu_Set_Jit) */
+static u8 jit_enabled;
+#endif /* #ifdef USE_JIT */
+
+/* Idle loops.  A block that branches back to its own start and only
+ * reads registers, memory and PPUSTATUS is a polling loop: once it has
+ * gone round twice from the same register state with nothing else
+ * running in between, every further time round is the same until the
+ * PPU next changes PPUSTATUS (and maybe raises NMI), which it only does
+ * at scheduled events.  Up to then the loop is skipped by just adding
+ * its cycles (see Idle_Loop). */
+typedef struct idle_loop {
+    decoded_block *blk;     /* Loop being watched, if any */
+    u16 pc;                 /* PC the loop starts at */
+    u32 key;                /* A, X, Y and P at the last time round */
+    u64 at;                 /* cpu.cycles at the last time round */
+    u32 frame;              /* ppu.frame the watch started in */
+    u8 status;              /* ppu.status the watch started with */
+    u32 runs;               /* Identical times round seen so far */
+} idle_loop;
+
+static idle_loop idle;
+
+/* Ranges of internal RAM that share a byte, mirrors included */
+#define RAM_OVERLAP(a, alen, b, blen)                                  \
+    ((u16)((b) - (a)) % RAM_BLOCK_SLOTS < (alen) ||                    \
+     (u16)((a) - (b)) % RAM_BLOCK_SLOTS < (blen))
+
+/* Base cycle count of each opcode */
+#define OP(code, name, mode, cycles) cycles,
+static const u8 op_base_cycles[] = {
+    OPCODE_LIST(OP)
+};
+#undef OP
+
+/* From opcode.c */
+extern const u8 op_mode[];
+extern const char *op_str[];
+extern const u8 mode_length[];
+
+/* Superinstructions: runs of instructions common enough in NES code to
+ * get a handler of their own, with a single cycle update for the run.
+ * Each instruction is given as (opcode, name, mode).  Only the last
+ * instruction of a run may write memory or branch, and absolute
+ * operands must be internal RAM, so nothing in a run can see the cycle
+ * count part way through it (see Fuse_Block). */
+#define FUSED_PAIRS(f)                                                 \
+    f(0,  0xCA, DEX, IP, 0xD0, BNE, RE)                                \
+    f(1,  0x88, DEY, IP, 0xD0, BNE, RE)                                \
+    f(2,  0xE8, INX, IP, 0xD0, BNE, RE)                                \
+    f(3,  0xC8, INY, IP, 0xD0, BNE, RE)                                \
+    f(4,  0xC9, CMP, IM, 0xF0, BEQ, RE)                                \
+    f(5,  0xC9, CMP, IM, 0xD0, BNE, RE)                                \
+    f(6,  0xA5, LDA, ZP, 0x29, AND, IM)                                \
+    f(7,  0xA9, LDA, IM, 0x85, STA, ZP)                                \
+    f(8,  0xA5, LDA, ZP, 0x85, STA, ZP)                                \
+    f(9,  0xA9, LDA, IM, 0x8D, STA, AB)                                \
+    f(10, 0xAD, LDA, AB, 0x8D, STA, AB)
+
+#define FUSED_TRIPLES(f)                                               \
+    f(11, 0xC8, INY, IP, 0xC0, CPY, IM, 0xD0, BNE, RE)                 \
+    f(12, 0xE8, INX, IP, 0xE0, CPX, IM, 0xD0, BNE, RE)
+
+/* Upper bound on the cycles of any run above, penalties included */
+#define FUSED_MAX_CYCLES 12
+
+typedef struct fused_pattern {
+    u8 count;
+    u8 opcode[3];
+} fused_pattern;
+
+#define PAIR_PATTERN(id, c1, n1, m1, c2, n2, m2) { 2, { c1, c2, 0 } },
+#define TRIPLE_PATTERN(id, c1, n1, m1, c2, n2, m2, c3, n3, m3) { 3, { c1, c2, c3 } },
+static const fused_pattern fused_patterns[] = {
+    FUSED_PAIRS(PAIR_PATTERN)
+    FUSED_TRIPLES(TRIPLE_PATTERN)
+};
+#undef PAIR_PATTERN
+#undef TRIPLE_PATTERN
+
+#define FUSED_COUNT (sizeof(fused_patterns) / sizeof(fused_patterns[0]))
+
+#ifdef USE_PAIR_PROFILE
+/* Executed instruction pairs, [first][second] */
+static u32 pair_count[256][256];
+static u8 last_opcode;
+
+#define PROFILE(code) pair_count[last_opcode][code]++; last_opcode = (code)
+#else
+#define PROFILE(code)
+#endif /* #ifdef USE_PAIR_PROFILE */
+
+/* Does this opcode end a block?  Anything that may load PC does, as
+ * does anything we don't support, and anything that may clear I (so a
+ * waiting IRQ is taken right after it, see CHECK_IRQ). */
+static INLINED u8 Ends_Block(u8 opcode) {
+    switch (opcode) {
+        case 0x00:  /* BRK */
+        case 0x20:  /* JSR */
+        case 0x28:  /* PLP */
+        case 0x40:  /* RTI */
+        case 0x58:  /* CLI */
+        case 0x4C:  /* JMP */
+        case 0x60:  /* RTS */
+        case 0x6C:  /* JMP (ind) */
+            return 1;
+        default:
+            return (RE == op_mode[opcode]) || !op_base_cycles[opcode];
+    }
+}
+
+/* Worst-case extra cycles an opcode may take on top of its base count */
+static INLINED u8 Max_Penalty(u8 opcode) {
+    switch (op_mode[opcode]) {
+        case RE: return 2;
+        case AX: case AY: case IY: return 1;
+        default: return 0;
+    }
+}
+
+/* Drop every decoded block. */
+static void Flush_Blocks(void) {
+    memset(rom_blocks, 0, sizeof(rom_blocks));
+    memset(ram_blocks, 0, sizeof(ram_blocks));
+    Mem_Clear_Code_Map();
+    block_count = 0;
+    idle.blk = 0;
+#ifdef USE_JIT
+    Jit_Reset();
+#endif /* #ifdef USE_JIT */
+}
+
+/* Func: void Cpu_Flush_Blocks(void)
+ * Desc: Discards all decoded code, e.g. after the PRG mapping changed.
+ *       The block currently running (if any) is left at the next
+ *       instruction boundary. */
+void Cpu_Flush_Blocks(void) {
+    Flush_Blocks();
+    cpu.pending |= CPU_PENDING_BLOCK_EXIT;
+}
+
+/* Func: void Cpu_Invalidate_Code(u16 offset)
+ * Desc: Called by Mem_Set when a byte of internal RAM that was decoded
+ *       into a block gets written.  Drops every block covering it. */
+void Cpu_Invalidate_Code(u16 offset) {
+    register i32 first = (i32)offset - (BLOCK_MAX_BYTES - 1);
+    register i32 i;
+    decoded_block *blk;
+
+    if (first < 0) first = 0;
+    for (i = first; i <= offset; i++) {
+        blk = ram_blocks[i];
+        if (blk && i + blk->bytes > offset) {
+            ram_blocks[i] = 0;
+            Mem_Mark_Code(i, blk->bytes, 0);
+        }
+    }
+    /* Re-mark whatever is left around the dropped blocks */
+    for (i = first; i <= offset + BLOCK_MAX_BYTES && i < RAM_BLOCK_SLOTS; i++) {
+        if (ram_blocks[i]) Mem_Mark_Code(i, ram_blocks[i]->bytes, 1);
+    }
+    cpu.pending |= CPU_PENDING_BLOCK_EXIT;
+}
+
+/* Func: void Cpu_Set_Jit(u8 enable)
+ * Desc: Switches native execution of hot PRG ROM blocks on or off.
+ *       Does nothing unless built with USE_JIT on x86-64. */
+void Cpu_Set_Jit(u8 enable) {
+#ifdef USE_JIT
+    /* Compiled blocks run whenever they are there, so drop them */
+    if (jit_enabled && !enable) Cpu_Flush_Blocks();
+    jit_enabled = enable;
+#endif /* #ifdef USE_JIT */
+}
+
+void Cpu_Report_Pairs(u32 top) {
+#ifdef USE_PAIR_PROFILE
+    static u8 shown[256][256];
+    register u32 i, j, n, best_i, best_j;
+    double total = 0;
+
+    for (i = 0; i < 256; i++) {
+        for (j = 0; j < 256; j++) total += pair_count[i][j];
+    }
+    if (total == 0) return;
+    memset(shown, 0, sizeof(shown));
+
+    printf("Most frequent instruction pairs (%.0f executed):\n", total);
+    for (n = 0; n < top; n++) {
+        best_i = best_j = 0;
+        for (i = 0; i < 256; i++) {
+            for (j = 0; j < 256; j++) {
+                if (!shown[i][j] && pair_count[i][j] > pair_count[best_i][best_j]) {
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+        }
+        if (shown[best_i][best_j] || !pair_count[best_i][best_j]) break;
+        shown[best_i][best_j] = 1;
+        printf("  %6.2f%%  %10u  %02X %-4s %02X %-4s\n",
+               100.0 * pair_count[best_i][best_j] / total, pair_count[best_i][best_j],
+               best_i, op_str[best_i], best_j, op_str[best_j]);
+    }
+#endif /* #ifdef USE_PAIR_PROFILE */
+}
+
+/* Does a decoded instruction only touch registers, zero page, immediate
+ * values or internal RAM at a fixed address? */
+static INLINED u8 Static_Ram_Operand(const decoded_op *op) {
+    return (AB != op_mode[op->opcode]) || (op->operand < RAM_BLOCK_END);
+}
+
+/* Point the first instruction of every superinstruction run in blk at
+ * its fused handler.  The other instructions keep their own handlers,
+ * which the fused handler falls back on when it can't run the whole
+ * thing at once. */
+#ifdef USE_COMPUTED_GOTO
+static void Fuse_Block(decoded_block *blk, const void **fused) {
+#else
+static void Fuse_Block(decoded_block *blk) {
+#endif /* #ifdef USE_COMPUTED_GOTO */
+    register const fused_pattern *pat;
+    register u32 i, j, k, best;
+
+    for (i = 0; i < blk->count; i++) {
+        best = FUSED_COUNT;
+        for (k = 0; k < FUSED_COUNT; k++) {
+            pat = &fused_patterns[k];
+            if (i + pat->count > blk->count) continue;
+            for (j = 0; j < pat->count; j++) {
+                if (blk->ops[i + j].opcode != pat->opcode[j]) break;
+                if (!Static_Ram_Operand(&blk->ops[i + j])) break;
+            }
+            if (j == pat->count &&
+                (FUSED_COUNT == best || pat->count > fused_patterns[best].count)) {
+                best = k;
+            }
+        }
+        if (FUSED_COUNT == best) continue;
+#ifdef USE_COMPUTED_GOTO
+        blk->ops[i].handler = fused[best];
+#else
+        blk->ops[i].handler = 0x200 | best;
+#endif /* #ifdef USE_COMPUTED_GOTO */
+        i += fused_patterns[best].count - 1;
+    }
+}
+
+/* Can an instruction be part of an idle loop?  It has to leave memory,
+ * the stack and the I flag alone and read only from RAM, PRG space or
+ * PPUSTATUS (reading which twice in a row has no further effect). */
+static u8 Idle_Safe(const decoded_op *op) {
+    switch (op->opcode) {
+        case 0xA9: case 0xA5: case 0xB5: case 0xAD: case 0xBD: case 0xB9: /* LDA */
+        case 0xA2: case 0xA6: case 0xB6: case 0xAE: case 0xBE:            /* LDX */
+        case 0xA0: case 0xA4: case 0xB4: case 0xAC: case 0xBC:            /* LDY */
+        case 0xC9: case 0xC5: case 0xD5: case 0xCD: case 0xDD: case 0xD9: /* CMP */
+        case 0xE0: case 0xE4: case 0xEC:                                  /* CPX */
+        case 0xC0: case 0xC4: case 0xCC:                                  /* CPY */
+        case 0x24: case 0x2C:                                             /* BIT */
+        case 0x29: case 0x25: case 0x35: case 0x2D: case 0x3D: case 0x39: /* AND */
+        case 0x09: case 0x05: case 0x15: case 0x0D: case 0x1D: case 0x19: /* ORA */
+        case 0x49: case 0x45: case 0x55: case 0x4D: case 0x5D: case 0x59: /* EOR */
+        case 0xAA: case 0xA8: case 0x8A: case 0x98:                       /* Txx */
+        case 0x18: case 0x38: case 0xB8: case 0xEA:                       /* CLC SEC CLV NOP */
+            break;
+        default:
+            return 0;
+    }
+    switch (op_mode[op->opcode]) {
+        case AB:
+            return (op->operand < RAM_BLOCK_END) || (op->operand == 0x2002) ||
+                   (op->operand >= 0x6000);
+        case AX: case AY:
+            return (op->operand + 0xFF < RAM_BLOCK_END) || (op->operand >= 0x6000);
+        default:
+            return 1;
+    }
+}
+
+/* Is the block decoded from start to end a loop back to its own start
+ * made of nothing but Idle_Safe instructions? */
+static u8 Is_Idle_Loop(const decoded_block *blk, u16 start, u16 end) {
+    register const decoded_op *last = &blk->ops[blk->count - 1];
+    register u32 i;
+
+    if (RE == op_mode[last->opcode]) {
+        if ((u16)(end + (i8)last->operand) != start) return 0;
+    } else if (0x4C == last->opcode) {  /* JMP */
+        if (last->operand != start) return 0;
+    } else {
+        return 0;
+    }
+    for (i = 0; i + 1 < blk->count; i++) {
+        if (!Idle_Safe(&blk->ops[i])) return 0;
+    }
+    return 1;
+}
+
+/* Called each time an idle loop block is entered, with the register
+ * state (key) and the cycles that may pass before the PPU next changes
+ * anything or the time slice ends (room).  Skips as many times round
+ * the loop as fit, leaving the last one to run normally, which then
+ * sees the PPU change or the end of the slice exactly where it would
+ * have anyway. */
+static void Idle_Loop(decoded_block *blk, u16 pc, u32 key, u32 room) {
+    register u32 cycles, n;
+
+    if (blk != idle.blk || pc != idle.pc || key != idle.key ||
+        ppu.frame != idle.frame || ppu.status != idle.status) {
+        idle.blk = blk;
+        idle.pc = pc;
+        idle.key = key;
+        idle.at = cpu.cycles;
+        idle.frame = ppu.frame;
+        idle.status = ppu.status;
+        idle.runs = 0;
+        return;
+    }
+    cycles = cpu.cycles - idle.at;
+    idle.at = cpu.cycles;
+    if (++idle.runs < 2) return;
+
+    n = room / cycles;
+    if (n < 2) return;
+    Cpu_Add_Cycles(cycles * (n - 1));
+    idle.at = cpu.cycles;
+}
+
+/* Fill and copy loops.  Blocks like
+ *
+ *      loop:   STA dst,X           loop:   LDA src,X
+ *              ...                         STA dst,X   ; or STA $2007
+ *              INX                         INX
+ *              BNE loop                    CPX #n
+ *                                          BNE loop
+ *
+ * with DEX, INY or DEY in place of INX (and Y indexing or (zp),Y
+ * operands to go with the Y ones), the compare being optional, are a
+ * memset or memcpy into internal RAM or a stream of bytes to PPUDATA.
+ * Bulk_Loop does all but the last time round of such a loop in one go,
+ * as far as that fits before the next PPU event or the end of the time
+ * slice. */
+#define IS_STEP_X(opcode)   (0xE8 == (opcode) || 0xCA == (opcode))  /* INX DEX */
+#define IS_STEP_Y(opcode)   (0xC8 == (opcode) || 0x88 == (opcode))  /* INY DEY */
+#define IS_STEP_UP(opcode)  (0xE8 == (opcode) || 0xC8 == (opcode))
+#define IS_COMPARE(opcode)  (0xE0 == (opcode) || 0xC0 == (opcode))  /* CPX CPY # */
+
+/* Is op an LDA (is_load) or STA indexed by X (use_x) or Y? */
+static u8 Bulk_Access(const decoded_op *op, u8 is_load, u8 use_x) {
+    switch (op->opcode) {
+        case 0xBD: case 0xB5: return is_load && use_x;    /* LDA a,X / zp,X */
+        case 0xB9: case 0xB1: return is_load && !use_x;   /* LDA a,Y / (zp),Y */
+        case 0x9D: case 0x95: return !is_load && use_x;   /* STA a,X / zp,X */
+        case 0x99: case 0x91: return !is_load && !use_x;  /* STA a,Y / (zp),Y */
+        default: return 0;
+    }
+}
+
+/* Is the block decoded from start to end a fill or copy loop? */
+static u8 Is_Bulk_Loop(const decoded_block *blk, u16 start, u16 end) {
+    register const decoded_op *op = &blk->ops[blk->count - 1];
+    register u32 i, n = blk->count - 1;
+    register u8 use_x;
+
+    if (0xD0 != op->opcode || (u16)(end + (i8)op->operand) != start) return 0;
+    if (n && IS_COMPARE(blk->ops[n - 1].opcode)) n--;
+    if (n < 2) return 0;
+
+    op = &blk->ops[--n];
+    if (!IS_STEP_X(op->opcode) && !IS_STEP_Y(op->opcode)) return 0;
+    use_x = IS_STEP_X(op->opcode);
+    if (n + 2 < blk->count &&
+        (0xE0 == blk->ops[n + 1].opcode) != use_x) return 0;
+
+    /* Copy: one load and one store */
+    if (Bulk_Access(&blk->ops[0], 1, use_x)) {
+        return (2 == n) && (Bulk_Access(&blk->ops[1], 0, use_x) ||
+                            (0x8D == blk->ops[1].opcode &&
+                             0x2007 == blk->ops[1].operand));
+    }
+    /* Fill: nothing but stores */
+    for (i = 0; i < n; i++) {
+        if (!Bulk_Access(&blk->ops[i], 0, use_x)) return 0;
+    }
+    return 1;
+}
+
+/* Called each time a fill or copy loop block is entered at pc, with
+ * the registers in cpu and room as for Idle_Loop.  Returns 1 if it ran
+ * some of the loop, leaving the registers, flags, memory and cycle
+ * count as if it had been run one instruction at a time. */
+static u8 Bulk_Loop(const decoded_block *blk, u16 pc, u32 room) {
+    register const decoded_op *op;
+    register u32 i, j, k, per;
+    u16 addr[BLOCK_MAX_OPS] = { 0 }, base, first;
+    u32 body = blk->count - 1, max_per, penalties = 0;
+    u8 *reg, up, target = 0, compare = 0, copy, to_ppu, v;
+    u8 buf[256];
+
+    /* Cpu_Exec(0) gets here with no room at all */
+    if (!room) return 0;
+    if (IS_COMPARE(blk->ops[body - 1].opcode)) {
+        compare = 1;
+        target = (u8)blk->ops[--body].operand;
+    }
+    op = &blk->ops[--body];
+    reg = IS_STEP_X(op->opcode) ? &cpu.x : &cpu.y;
+    up = IS_STEP_UP(op->opcode);
+    copy = Bulk_Access(&blk->ops[0], 1, IS_STEP_X(op->opcode));
+    to_ppu = copy && (0x8D == blk->ops[1].opcode);
+
+    /* Times round left, including the last (done by the caller), and
+     * the cycles each takes */
+    k = (u8)(up ? target - *reg : *reg - target);
+    k = (k ? k : 256) - 1;
+    if (up && k > 256u - *reg) k = 256 - *reg;
+    if (!up && k > *reg + 1u) k = *reg + 1;
+    per = blk->cycles + ((PAGE_OF(pc + blk->bytes) == PAGE_OF(pc)) ? 1 : 2);
+    max_per = per + copy;
+    if (to_ppu && Ppu_Cycles_To_Vram_Access() < room) {
+        room = Ppu_Cycles_To_Vram_Access();
+    }
+    if (room <= max_per) return 0;
+    if (k > (room - 1) / max_per) k = (room - 1) / max_per;
+    if (!k) return 0;
+
+    /* Lowest address each operand touches, with the index at its
+     * lowest, and the page crossing penalties of the load */
+    v = up ? *reg : *reg - (k - 1);
+    for (i = 0; i < body; i++) {
+        op = &blk->ops[i];
+        switch (op_mode[op->opcode]) {
+            case ZX:
+                addr[i] = (u8)(op->operand + v);
+                if (addr[i] + k > 0x100) return 0;
+                continue;
+            case AB:
+                addr[i] = op->operand;
+                continue;
+            case IY:
+                base = TO_U16(Mem_Fetch((u8)op->operand),
+                              Mem_Fetch((u8)(op->operand + 1)));
+                break;
+            default:
+                base = op->operand;
+                break;
+        }
+        addr[i] = base + v;
+        if ((u32)addr[i] + k > 0x10000) return 0;
+        if (copy && !i && (u32)(base & 0xFF) + v + k > 0x100) {
+            first = 0x100 - (base & 0xFF);  /* First index that crosses */
+            penalties = v + k - ((first > v) ? first : v);
+        }
+    }
+
+    /* Stores have to go to internal RAM without touching decoded code,
+     * the loads' source or a (zp),Y pointer */
+    for (i = copy; i < body && !to_ppu; i++) {
+        if (addr[i] + k > RAM_BLOCK_END || Mem_Is_Code(addr[i], k)) return 0;
+        if (copy && addr[0] < RAM_BLOCK_END &&
+            RAM_OVERLAP(addr[0], k, addr[i], k)) return 0;
+        for (j = 0; j < body; j++) {
+            op = &blk->ops[j];
+            if (IY == op_mode[op->opcode] &&
+                RAM_OVERLAP((u8)op->operand, 2, addr[i], k)) return 0;
+        }
+    }
+    /* and loads have to be free of side effects */
+    if (copy && (addr[0] + k > RAM_BLOCK_END) && addr[0] < 0x6000) return 0;
+
+    if (copy) {
+        Mem_Read_Block(buf, addr[0], k);
+        cpu.a = up ? buf[k - 1] : buf[0];
+        if (to_ppu) {
+            if (!up) {
+                for (i = 0; i < k / 2; i++) {
+                    v = buf[i]; buf[i] = buf[k - 1 - i]; buf[k - 1 - i] = v;
+                }
+            }
+            Ppu_Write_Data_Block(buf, k);
+        } else {
+            Mem_Write_Block(addr[1], buf, k);
+        }
+    } else {
+        for (i = 0; i < body; i++) Mem_Fill(addr[i], cpu.a, k);
+    }
+
+    *reg = up ? *reg + k : *reg - k;
+    v = compare ? (u8)(*reg - target) : *reg;
+    cpu.p = (cpu.p & ~(FLG_SIGN | FLG_ZERO)) | (v & FLG_SIGN) | (v ? 0 : FLG_ZERO);
+    if (compare) FLAG_COND(*reg >= target, cpu.p, FLG_CARRY);
+
+    Cpu_Add_Cycles(k * per + penalties);
+    return 1;
+}
+
+/* Decode the straight-line run starting at pc.  Returns 0 if pc is not
+ * in a cacheable region. */
+#ifdef USE_COMPUTED_GOTO
+static decoded_block *Decode_Block(u16 pc, const void **body,
+                                   const void **fused) {
+#else
+static decoded_block *Decode_Block(u16 pc) {
+#endif /* #ifdef USE_COMPUTED_GOTO */
+    register decoded_block *blk;
+    register decoded_op *op;
+    register u8 opcode, length;
+    u8 in_ram = pc < RAM_BLOCK_END;
+    u16 start = pc;
+
+    if (!in_ram && pc < ROM_BLOCK_BASE) return 0;
+    if (BLOCK_POOL_SIZE == block_count) Flush_Blocks();
+
+    blk = &block_pool[block_count];
+    blk->count = blk->bytes = 0;
+    blk->cycles = blk->max_cycles = 0;
+    blk->hits = 0;
+    blk->native = 0;
+
+    do {
+        opcode = Mem_Fetch(pc);
+        length = mode_length[op_mode[opcode]];
+
+        /* Never decode past the end of RAM (the next mirror might as
+         * well be I/O) or past $FFFF. */
+        if (in_ram ? ((pc % RAM_BLOCK_SLOTS) + length > RAM_BLOCK_SLOTS)
+                   : ((u32)pc + length > 0x10000)) break;
+
+        op = &blk->ops[blk->count++];
+#ifdef USE_COMPUTED_GOTO
+        op->handler = body[opcode];
+#else
+        op->handler = 0x100 | opcode;
+#endif /* #ifdef USE_COMPUTED_GOTO */
+        op->opcode = opcode;
+        op->length = length;
+        op->operand = (length > 1) ? Mem_Fetch(pc + 1) : 0;
+        if (length > 2) op->operand |= (u16)Mem_Fetch(pc + 2) << 8;
+
+        blk->cycles += op_base_cycles[opcode];
+        blk->max_cycles += op_base_cycles[opcode] + Max_Penalty(opcode);
+        blk->bytes += length;
+        pc += length;
+    } while (!Ends_Block(opcode) && blk->count < BLOCK_MAX_OPS);
+
+    if (!blk->count) return 0;
+    block_count++;
+    blk->loop = Is_Idle_Loop(blk, start, pc) ? BLOCK_LOOP_IDLE :
+                Is_Bulk_Loop(blk, start, pc) ? BLOCK_LOOP_BULK :
+                BLOCK_LOOP_NONE;
+
+#ifdef USE_COMPUTED_GOTO
+    Fuse_Block(blk, fused);
+#else
+    Fuse_Block(blk);
+#endif /* #ifdef USE_COMPUTED_GOTO */
+
+    if (in_ram) {
+        blk->pc = start % RAM_BLOCK_SLOTS;
+        ram_blocks[blk->pc] = blk;
+        Mem_Mark_Code(blk->pc, blk->bytes, 1);
+    } else {
+        blk->pc = start;
+        blk->src[0] = Mem_Get_Page(start);
+        blk->src[1] = Mem_Get_Page(start + blk->bytes - 1);
+        rom_blocks[start - ROM_BLOCK_BASE] = blk;
+#ifdef USE_AOT
+        blk->native = Aot_Find(blk);
+#endif /* #ifdef USE_AOT */
+    }
+    return blk;
+}
+
+static INLINED decoded_block *Find_Block(u16 pc) {
+    register decoded_block *blk;
+
+    if (pc >= ROM_BLOCK_BASE) {
+        /* Bank switches only repoint the page table, so a block is
+         * stale if its bytes no longer come from the same pages; it
+         * is decoded again over the old one. */
+        blk = rom_blocks[pc - ROM_BLOCK_BASE];
+        if (blk && (blk->src[0] != Mem_Get_Page(pc) ||
+                    blk->src[1] != Mem_Get_Page(pc + blk->bytes - 1))) {
+            return 0;
+        }
+        return blk;
+    }
+    if (pc < RAM_BLOCK_END) return ram_blocks[pc % RAM_BLOCK_SLOTS];
+    return 0;
+}
+
+/* Dispatch.  With computed goto, every handler ends in its own
+ * indirect jump, which gives the branch predictor one entry per
+ * opcode instead of a single shared one.  Each handler has two entry
+ * points: op_XX fetches the operand from memory, body_XX expects it to
+ * have been loaded from a decoded block.  The switch build gets the
+ * same effect by falling through from case XX to case 0x1XX. */
+#ifdef USE_COMPUTED_GOTO
+#define LABEL(code, name, mode, cycles) &&op_##code,
+#define BODY_LABEL(code, name, mode, cycles) &&body_##code,
+#define FUSED_LABEL(id, ...) &&fused_##id,
+#define CASE(code) op_##code:
+#define BODY(code) body_##code:
+#define FUSED_CASE(id) fused_##id:
+#define UNFUSED(code) goto body_##code
+#define DISPATCH() goto *op_label[FETCH_BYTE()]
+#define DISPATCH_DECODED()                                             \
+    operand = ip->operand; PC += ip->length;                           \
+    goto *(ip++)->handler
+#else
+#define CASE(code) case code:
+#define BODY(code) case 0x100 | code:
+#define FUSED_CASE(id) case 0x200 | id:
+#define UNFUSED(code) next = 0x100 | code; goto run
+#define DISPATCH() next = FETCH_BYTE(); goto run
+#define DISPATCH_DECODED()                                             \
+    operand = ip->operand; PC += ip->length;                           \
+    next = (ip++)->handler; goto run
+#endif /* #ifdef USE_COMPUTED_GOTO */
+
+/* Cycles that may pass before the end of the time slice or the next
+ * scheduled event (such as vblank, which may raise NMI) */
+#define ROOM()                                                         \
+    (u32)((sched_next - cpu.cycles < budget - (cpu.cycles - start)) ?  \
+          sched_next - cpu.cycles : budget - (cpu.cycles - start))
+
+/* Inside a block, keep going until its last instruction; outside of
+ * one, check the budget and look for the next block. */
+#define NEXT()                                                         \
+    if (cpu.pending) goto pending;                                     \
+    if (ip != ip_end) { DISPATCH_DECODED(); }                          \
+    if (cpu.cycles - start >= budget) goto done;                       \
+    goto lookup
+
+#define FETCH(m) FETCH_##m
+
+#define HANDLER(code, name, mode, cycles)                              \
+    CASE(code) FETCH(mode);                                            \
+    BODY(code) {                                                       \
+        PROFILE(code);                                                 \
+        extra = 0;                                                     \
+        EXEC_##name(mode);                                             \
+        Cpu_Add_Cycles((cycles) + extra);                              \
+        NEXT();                                                        \
+    }
+
+/* Superinstructions.  The cycles of the whole run are added at the end,
+ * which is only exact if no event fires part way through; closer than
+ * that to the next one the run is executed one instruction at a time
+ * instead.  FUSED_STEP moves on to the next decoded instruction
+ * without dispatching it. */
+#define FUSED_STEP() operand = ip->operand; PC += ip->length; ip++
+
+#define FUSED_ENTER(c1)                                                \
+    if (sched_next - cpu.cycles <= FUSED_MAX_CYCLES) {                 \
+        UNFUSED(c1);                                                   \
+    }                                                                  \
+    extra = 0
+
+#define PAIR_HANDLER(id, c1, n1, m1, c2, n2, m2)                       \
+    FUSED_CASE(id) {                                                   \
+        FUSED_ENTER(c1);                                               \
+        PROFILE(c1); EXEC_##n1(m1);                                    \
+        FUSED_STEP(); PROFILE(c2); EXEC_##n2(m2);                      \
+        Cpu_Add_Cycles(op_base_cycles[c1] + op_base_cycles[c2] + extra); \
+        NEXT();                                                        \
+    }
+
+#define TRIPLE_HANDLER(id, c1, n1, m1, c2, n2, m2, c3, n3, m3)         \
+    FUSED_CASE(id) {                                                   \
+        FUSED_ENTER(c1);                                               \
+        PROFILE(c1); EXEC_##n1(m1);                                    \
+        FUSED_STEP(); PROFILE(c2); EXEC_##n2(m2);                      \
+        FUSED_STEP(); PROFILE(c3); EXEC_##n3(m3);                      \
+        Cpu_Add_Cycles(op_base_cycles[c1] + op_base_cycles[c2] +       \
+                       op_base_cycles[c3] + extra);                    \
+        NEXT();                                                        \
+    }
+
+/* Func: u32 Cpu_Exec(u32 budget)
+ * Desc: Runs whole instructions until at least budget cycles have
+ *       elapsed.  Returns the number of cycles actually run.  A
+ *       decoded block is only entered if it is certain to finish within
+ *       the budget, so the result is the same as stepping one
+ *       instruction at a time. */
+u32 Cpu_Exec(u32 budget) {
+    register u64 start = cpu.cycles;
+    register u16 addr, operand = 0;
+    register u8 v, c, taken;
+    register u32 extra;
+    register decoded_op *ip = 0, *ip_end = 0;
+    register decoded_block *blk;
+    register u8 reg_a, reg_x, reg_y, reg_s, reg_p;
+    register u16 reg_pc;
+#ifdef USE_LAZY_FLAGS
+    register u8 flag_n, flag_z, flag_c, flag_v;
+#endif /* #ifdef USE_LAZY_FLAGS */
+#ifdef USE_COMPUTED_GOTO
+    static const void *op_label[] = {
+        OPCODE_LIST(LABEL)
+    };
+    static const void *body_label[] = {
+        OPCODE_LIST(BODY_LABEL)
+    };
+    static const void *fused_label[] = {
+        FUSED_PAIRS(FUSED_LABEL)
+        FUSED_TRIPLES(FUSED_LABEL)
+    };
+#else
+    register u16 next = 0;
+#endif /* #ifdef USE_COMPUTED_GOTO */
+
+    LOAD_REGS();
+    /* Events are always in the future from here on (see ROOM and the
+     * checks in superinstructions and native blocks) */
+    if (cpu.cycles >= sched_next) Sched_Run(cpu.cycles);
+
+lookup:
+    blk = Find_Block(PC);
+    if (!blk) {
+#ifdef USE_COMPUTED_GOTO
+        blk = Decode_Block(PC, body_label, fused_label);
+#else
+        blk = Decode_Block(PC);
+#endif /* #ifdef USE_COMPUTED_GOTO */
+    }
+    if (blk && BLOCK_LOOP_IDLE == blk->loop) {
+        SYNC_FLAGS();
+        Idle_Loop(blk, PC, A | (X << 8) | (Y << 16) | ((u32)P << 24), ROOM());
+    } else {
+        /* Anything but the watched loop itself (which runs a
+         * partial time round one instruction at a time at the end of
+         * a slice) stops the watch */
+        if (idle.blk && (u16)(PC - idle.pc) >= idle.blk->bytes) idle.blk = 0;
+        if (blk && BLOCK_LOOP_BULK == blk->loop) {
+            SYNC_REGS();
+            if (Bulk_Loop(blk, PC, ROOM())) LOAD_REGS();
+        }
+    }
+    if (blk && (cpu.cycles - start + blk->max_cycles < budget)) {
+#if defined(USE_JIT) || defined(USE_AOT)
+        /* Native blocks (compiled or translated ahead of time) add
+         * their cycles all at once, so they must not run across the
+         * next event.  A block that leaves before its
+         * first instruction returns 0 and is interpreted instead. */
+        if (blk->native && sched_next - cpu.cycles > blk->max_cycles) {
+            SYNC_REGS();
+            extra = blk->native();
+            LOAD_REGS();
+            if (extra) {
+                CHECK_IRQ();
+                Cpu_Add_Cycles(extra);
+                ip = ip_end = 0;
+                NEXT();
+            }
+        }
+#ifdef USE_JIT
+        else if (jit_enabled && !blk->native &&
+                 JIT_HOT_THRESHOLD == ++blk->hits) {
+            blk->native = Jit_Compile(blk);
+        }
+#endif /* #ifdef USE_JIT */
+#endif /* #if defined(USE_JIT) || defined(USE_AOT) */
+        ip = blk->ops;
+        ip_end = ip + blk->count;
+        DISPATCH_DECODED();
+    }
+    ip = ip_end = 0;
+    DISPATCH();
+
+#ifdef USE_COMPUTED_GOTO
+    OPCODE_LIST(HANDLER)
+    FUSED_PAIRS(PAIR_HANDLER)
+    FUSED_TRIPLES(TRIPLE_HANDLER)
+#else
+run:
+    switch (next) {
+        OPCODE_LIST(HANDLER)
+        FUSED_PAIRS(PAIR_HANDLER)
+        FUSED_TRIPLES(TRIPLE_HANDLER)
+    }
+#endif /* #ifdef USE_COMPUTED_GOTO */
+
+pending:
+    /* Interrupts are taken between instructions, and always leave the
+     * current block. */
+    ip = ip_end = 0;
+    idle.blk = 0;
+    taken = cpu.pending;
+    cpu.pending = 0;    /* Taking an IRQ runs the clock, which may raise an NMI */
+    if (IS_SET(taken, CPU_PENDING_STALL)) {
+        Cpu_Run_Stall();
+        taken |= cpu.pending;
+        cpu.pending = 0;
+    }
+    if (IS_SET(taken, CPU_PENDING_NMI)) {
+        SYNC_REGS();
+        Do_Nmi();
+        LOAD_REGS();
+    } else if (cpu.irq && !IS_SET(P, FLG_INT_DIS)) {
+        SYNC_REGS();
+        Do_Irq();
+        LOAD_REGS();
+    }
+    if (cpu.cycles - start < budget) goto lookup;
+
+done:
+    SYNC_REGS();
+    return (u32)(cpu.cycles - start);
+}
@@ -18,6 +18,7 @@
 
 #include "cpu.h"
 #include "mem.h"
+#include "sched.h"
 #include "opcode.h"
 #include "bitwise.h"
 
@@ -28,52 +29,106 @@
 /* Instance of the cpu */
 cpu_6502 cpu;
 
-/* External method for increasing PPU cycles */
-extern void Ppu_Add_Cycles(u32 cycles);
+const u8 *cpu_fetch_page;
+u16 cpu_fetch_base;
 
 /* Func: void cpu_init(void)
  * Desc: sets the cpu into it's initial state. Note that this is not the
  * same as pressing the reset button. */
-INLINED void Cpu_Init(void) {
+void Cpu_Init(void) {
     cpu.a = cpu.x = cpu.y = 0;
     cpu.s = CPU_STACK_INIT;
     cpu.p = CPU_STATUS_INIT;
     
     cpu.pc = CPU_PC_RESET;
+    cpu.pending = 0;
+    cpu.irq = 0;
+    cpu.stall = 0;
     neslog("CPU Initialized.\n");
 }
 
 /* Func: void cpu_reset(void)
  * Desc: Alters cpu state to emulate pressing the "reset" button. */
-INLINED void Cpu_Reset(void) {
+void Cpu_Reset(void) {
     cpu.s -= 3;
     /* FLAG_SET(cpu.p, IRQ_DISABLE); */
     cpu.pc = CPU_PC_RESET;
     neslog("CPU Reset.\n");
 }
 
-/* Func: u8 cpu_fetch(void)
- * Desc: Fetches the next byte from memory. */
-INLINED u8 Cpu_Fetch(void) {
-    return Mem_Fetch(cpu.pc++);
-} 
+/* Func: void Cpu_Flush_Fetch(void)
+ * Desc: Drops the page Cpu_Fetch reads from, for when the memory map
+ *       changes.  A decoded block being run is left at the next
+ *       instruction, since the rest of it may have been switched out. */
+void Cpu_Flush_Fetch(void) {
+    cpu_fetch_page = 0;
+    cpu.pending |= CPU_PENDING_BLOCK_EXIT;
+}
+
+VNES_Err Cpu_Step(void) {
+    register VNES_Err err = Dispatch_Opcode(Cpu_Fetch());
+
+    Cpu_Take_Interrupts();
+    return err;
+}
+
+/* Func: void Cpu_Take_Interrupts(void)
+ * Desc: Takes an NMI or IRQ waiting at an instruction boundary, as
+ *       Cpu_Step does after each instruction.  Taking one runs the
+ *       clock, which may raise an NMI for after it. */
+void Cpu_Take_Interrupts(void) {
+    register u8 pending = cpu.pending;
+
+    cpu.pending = 0;
+    if (IS_SET(pending, CPU_PENDING_STALL)) {
+        Cpu_Run_Stall();
+        pending |= cpu.pending;
+        cpu.pending = 0;
+    }
+    if (IS_SET(pending, CPU_PENDING_NMI)) Do_Nmi();
+    else if (cpu.irq && !IS_SET(cpu.p, FLG_INT_DIS)) Do_Irq();
+}
+
+/* Func: void Cpu_Stall(u16 cycles)
+ * Desc: Halts the CPU for a DMA once the current instruction (the store
+ *       that started it) completes, so that the stall is timed from the
+ *       cycle after the write whichever addressing mode made it. */
+void Cpu_Stall(u16 cycles) {
+    cpu.stall += cycles;
+    FLAG_SET(cpu.pending, CPU_PENDING_STALL);
+}
+
+/* Func: void Cpu_Run_Stall(void)
+ * Desc: Runs the clock through the stall Cpu_Stall asked for.  A DMA
+ *       starts on an even cycle, so one more is spent on an odd one.
+ *       Running the clock may raise an NMI, taken straight after. */
+void Cpu_Run_Stall(void) {
+    register u32 cycles = cpu.stall + (u32)(cpu.cycles & 1);
 
-INLINED void Cpu_Add_Cycles(u32 cycles) {
-    cpu.cycles += cycles;
-    Ppu_Add_Cycles(3 * cycles);
-    //if (cpu.cycles > 3 * (1025 * 261)) cpu.cycles %= (1025 * 261);
+    cpu.stall = 0;
+    Cpu_Add_Cycles(cycles);
 }
 
-INLINED u32 Cpu_Get_Cycles(void) {
-    return cpu.cycles;
+/* Func: void Cpu_Nmi(void)
+ * Desc: Signals an NMI.  It is taken once the current instruction
+ *       completes. */
+void Cpu_Nmi(void) {
+    FLAG_SET(cpu.pending, CPU_PENDING_NMI);
 }
 
-INLINED VNES_Err Cpu_Step(void) {
-    return Dispatch_Opcode(Cpu_Fetch());
+/* Func: void Cpu_Irq(u8 source)
+ * Desc: Pulls the IRQ line low for a source (CPU_IRQ_*).  Unlike an NMI
+ *       it stays asserted until the source is acknowledged, and is
+ *       taken between instructions whenever the I flag is clear. */
+void Cpu_Irq(u8 source) {
+    cpu.irq |= source;
+    FLAG_SET(cpu.pending, CPU_PENDING_IRQ);
 }
 
-INLINED void Cpu_Nmi(void) {
-    Do_Nmi();
+/* Func: void Cpu_Ack_Irq(u8 source)
+ * Desc: Releases the IRQ line for a source. */
+void Cpu_Ack_Irq(u8 source) {
+    cpu.irq &= ~source;
 }
 
 /* Func: VNES_Err Cpu_Run(void)
@@ -82,14 +137,12 @@ INLINED void Cpu_Nmi(void) {
 void Cpu_Run(void) {
     cpu.state = 1;
     while (cpu.state) {
-        /* Handle next instruction */
-        if (!Cpu_Step()) {
-			neslog("\n============[End of CPU Execution]===========\n");
-			break;
-		}
+        /* Handle the next slice of instructions */
+        Cpu_Exec(CPU_RUN_SLICE);
         
         /* Check scanline/interrupts */
     }
+    neslog("\n============[End of CPU Execution]===========\n");
 }
 
 void Cpu_Dump(void) {
@@ -34,7 +34,7 @@ extern cpu_6502 cpu;
 
 vnes_display *disp__;
 
-INLINED int Handle_Debug_Input(vnes_display *disp, const char *cmd);
+int Handle_Debug_Input(vnes_display *disp, const char *cmd);
 
 void Start_Debug(u32 flags) {
     if (IS_SET(flags, NO_GFX)) {
@@ -50,16 +50,17 @@ void End_Debug(int sig) {
     Close_Display(disp__);
 }
 
-INLINED int Handle_Debug_Input(vnes_display *disp, const char *cmd) {
+int Handle_Debug_Input(vnes_display *disp, const char *cmd) {
     /* Handle single-character input */
     if (!cmd[1]) {
         switch (*cmd) {
             case 'q': End_Debug(0); return 0;
+            case 'p': Cpu_Report_Pairs(32); break;
             case 'f': {
                 printf("Rendering next frame...\n");
                 ppu.frame_check = 1;
                 while (ppu.frame_check) {
-                    Cpu_Step();
+                    Cpu_Exec(CPU_RUN_SLICE);
                 }
                 if (ppu.mask & (SHOW_BG | SHOW_SPRITES)) {
                     Set_Display_Source(disp, Get_Render_Buffer(), NES_RES_X, NES_RES_Y);
@@ -229,6 +229,7 @@ void Log_Instruction(void) {
     char line[128];
     u8 ops[3], len, i;
 
+    Ppu_Sync();
     sprintf(line, "%04X ", cpu.pc);
 
     /* Get ops */
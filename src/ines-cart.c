@@ -16,23 +16,43 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "ines-cart.h"
+#include "ines-mappers.h"
+#include "mem.h"
+#include "ppu.h"
+
+#define PRG_BANKS_PER_PAGE (INES_PRG_PAGE_SIZE / INES_PRG_BANK_SIZE)
+#define CHR_BANKS_PER_PAGE (INES_CHR_PAGE_SIZE / INES_CHR_BANK_SIZE)
+#define TILES_PER_PAGE     (INES_CHR_PAGE_SIZE / CHR_TILE_BYTES)
+#define TILES_PER_BANK     (INES_CHR_BANK_SIZE / CHR_TILE_BYTES)
 
 /* Load/Free PRG/CHR ROM pages */
 static void Load_iNES_Pages(ines_cart *cart, FILE *fp);
 static void Free_iNES_Pages(ines_cart *cart);
 
-/* For now, we define mapper 0 functions in this file. */
-static u8 Read_iNES0_Prg(icart *cart, u16 address);
-static u8 Read_iNES0_Chr(icart *cart, u16 address);
+/* Map/Unmap PRG RAM */
+static void Map_iNES_Prg_Ram(ines_cart *cart, const char *path);
+static void Unmap_iNES_Prg_Ram(ines_cart *cart);
+static void Sync_iNES_Ram(icart *cart, u8 wait);
+
+/* Save/load the board's state (see Save_Cartridge_State) */
+static void Save_iNES_State(icart *cart, u8 *state);
+static void Load_iNES_State(icart *cart, const u8 *state);
 
-static u8 Write_iNES0_Prg(icart *cart, u16 address, u8 value);
-static u8 Write_iNES0_Chr(icart *cart, u16 address, u8 value);
+/* Accessors shared by every mapper; they only go through the windows */
+static u8 Read_iNES_Prg(icart *cart, u16 address);
 
-static void Unload_iNES0(icart *cart);
+static u8 Write_iNES_Chr(icart *cart, u16 address, u8 value);
 
-icart *Load_iNES(FILE *fp) {
+static void Unload_iNES(icart *cart);
+
+icart *Load_iNES(FILE *fp, const char *path) {
     ines_cart *cart;
+    const ines_mapper *mapper;
     u8 header[12];      /* Header container */
     u8 mapper_id;       /* Mapper ID extracted from header */
     
@@ -41,21 +61,24 @@ icart *Load_iNES(FILE *fp) {
         return 0;
     }
     
-    mapper_id = (header[3] >> 4) | (header[2] >> 4);
-    /* Later, we'll want a jump table here for different mappers */
-    if (0 == mapper_id) {
-        cart = (ines_cart *)malloc(sizeof(ines_cart));
-        bzero(cart, sizeof(ines_cart));
-        
-        cart->type = CART_INES;
-        cart->Read_Prg = Read_iNES0_Prg;
-        cart->Read_Chr = Read_iNES0_Chr;
-        cart->Write_Prg = Write_iNES0_Prg;
-        cart->Write_Chr = Write_iNES0_Chr;
-        cart->Unload = Unload_iNES0;
-    } else {
+    /* Low nibble in flags 6, high nibble in flags 7 */
+    mapper_id = (header[3] & 0xF0) | (header[2] >> 4);
+    mapper = Find_iNES_Mapper(mapper_id);
+    if (!mapper) {
+        printf("Unsupported mapper: %u\n", mapper_id);
         return 0;
     }
+
+    cart = (ines_cart *)malloc(mapper->size);
+    bzero(cart, mapper->size);
+
+    cart->type = CART_INES;
+    cart->Read_Prg = Read_iNES_Prg;
+    cart->Write_Prg = mapper->Write_Prg;
+    cart->Write_Chr = Write_iNES_Chr;
+    cart->Save_State = Save_iNES_State;
+    cart->Load_State = Load_iNES_State;
+    cart->Unload = Unload_iNES;
     
     cart->mapper_id = mapper_id;
     cart->prg_pages = header[0];
@@ -71,17 +94,19 @@ icart *Load_iNES(FILE *fp) {
     cart->flags |= (header[5] & 0x01) ? INES_IS_PAL : 0;
     
     Load_iNES_Pages(cart, fp);
+    Map_iNES_Prg_Ram(cart, path);
+    mapper->Reset(cart);
     
     printf(
         "Cartridge loaded:\n"
-        "\tMapper: %u\n"
+        "\tMapper: %u (%s)\n"
         "\tPRG Pages: %u\n"
         "\tCHR Pages: %u\n"
         "\tMirror Mode: %u\n"
         "\tHas Trainer: %s\n"
         "\tHas Save RAM: %s\n"
         "\tVideo type: %s\n",
-        cart->mapper_id, cart->prg_pages, cart->chr_pages, cart->flags & INES_MIRROR_MASK,
+        cart->mapper_id, mapper->name, cart->prg_pages, cart->chr_pages, cart->flags & INES_MIRROR_MASK,
         (cart->flags & INES_HAS_TRAINER) ? "yes" : "no",
         (cart->flags & INES_HAS_SAVERAM) ? "yes" : "no",
         (cart->flags & INES_IS_PAL) ? "PAL" : "NTSC");
@@ -114,6 +139,24 @@ static void Load_iNES_Pages(ines_cart *cart, FILE *fp) {
             //goto err;
         }
     }
+
+    /* Boards without CHR ROM have 8K of CHR RAM instead */
+    if (!cart->chr_pages) {
+        cart->chr_ram = (u8 *)malloc(sizeof(u8) * INES_CHR_PAGE_SIZE);
+        bzero(cart->chr_ram, sizeof(u8) * INES_CHR_PAGE_SIZE);
+    }
+
+    /* Decode every tile up front; CHR RAM is kept decoded as it is
+     * written (see Write_iNES_Chr) */
+    i = cart->chr_pages ? cart->chr_pages : 1;
+    cart->chr_tiles = (chr_tile *)malloc(sizeof(chr_tile) * TILES_PER_PAGE * i);
+    if (cart->chr_ram) {
+        Decode_Chr_Tiles(cart->chr_tiles, cart->chr_ram, TILES_PER_PAGE);
+    }
+    for (i = 0; i < cart->chr_pages; i++) {
+        Decode_Chr_Tiles(cart->chr_tiles + i * TILES_PER_PAGE,
+                         cart->chr_rom[i], TILES_PER_PAGE);
+    }
 }
 
 static void Free_iNES_Pages(ines_cart *cart) {
@@ -132,30 +175,211 @@ static void Free_iNES_Pages(ines_cart *cart) {
             }
             free(cart->chr_rom);
         }
+        free(cart->chr_ram);
+        free(cart->chr_tiles);
+    }
+}
+
+/* Where a ROM's battery-backed RAM is saved: the ROM's path with its
+ * extension replaced by .sav.  Freed by the caller. */
+static char *Save_Path(const char *path) {
+    register const char *ext = strrchr(path, '.');
+    register size_t length;
+    char *save;
+
+    if (!ext || strchr(ext, '/')) ext = path + strlen(path);
+    length = ext - path;
+    save = (char *)malloc(length + sizeof(".sav"));
+    memcpy(save, path, length);
+    strcpy(save + length, ".sav");
+    return save;
+}
+
+/* Opens the save file for mapping, creating it or extending a short one
+ * to the size of PRG RAM.  One that is larger than that was not written
+ * by this board and is left alone rather than cut down.  On failure,
+ * says why and returns -1. */
+static int Open_Save_File(const char *save) {
+    register int fd = open(save, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+
+    if (fd < 0) {
+        printf("Can't open save file %s\n", save);
+        return -1;
+    }
+    if (0 != fstat(fd, &st)) {
+        printf("Can't open save file %s\n", save);
+        close(fd);
+        return -1;
+    }
+    if (st.st_size > INES_PRG_RAM_SIZE) {
+        printf("Save file %s is larger than %d bytes, not using it\n",
+               save, INES_PRG_RAM_SIZE);
+        close(fd);
+        return -1;
+    }
+    if (st.st_size < INES_PRG_RAM_SIZE && 0 != ftruncate(fd, INES_PRG_RAM_SIZE)) {
+        printf("Can't extend save file %s\n", save);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* PRG RAM.  With a battery it is the .sav file mapped shared, so saving
+ * costs the game plain stores: dirty pages reach the file through the
+ * page cache even if VNES crashes, and Sync_iNES_Ram only bounds how
+ * far behind the disk may be.  Without a battery, or if the file can't
+ * be used, it is ordinary memory. */
+static void Map_iNES_Prg_Ram(ines_cart *cart, const char *path) {
+    register char *save;
+    register int fd;
+    void *data;
+
+    if (cart->flags & INES_HAS_SAVERAM) {
+        save = Save_Path(path);
+        fd = Open_Save_File(save);
+        if (fd >= 0) {
+            data = mmap(0, INES_PRG_RAM_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+            if (MAP_FAILED != data) {
+                cart->prg_ram = (u8 *)data;
+                cart->prg_ram_file = 1;
+                cart->Sync_Ram = Sync_iNES_Ram;
+            } else {
+                printf("Can't map save file %s\n", save);
+            }
+            close(fd);
+        }
+        free(save);
+    }
+    if (!cart->prg_ram) {
+        cart->prg_ram = (u8 *)malloc(sizeof(u8) * INES_PRG_RAM_SIZE);
+        bzero(cart->prg_ram, sizeof(u8) * INES_PRG_RAM_SIZE);
     }
+    Mem_Map_Prg_Ram(cart->prg_ram);
 }
 
-/* For now, we define mapper 0 functions in this file. */
-static u8 Read_iNES0_Prg(icart *cart, u16 address) {
+static void Unmap_iNES_Prg_Ram(ines_cart *cart) {
+    Mem_Map_Prg_Ram(0);
+    if (cart->prg_ram_file) {
+        msync(cart->prg_ram, INES_PRG_RAM_SIZE, MS_SYNC);
+        munmap(cart->prg_ram, INES_PRG_RAM_SIZE);
+    } else {
+        free(cart->prg_ram);
+    }
+    cart->prg_ram = 0;
+}
+
+static void Sync_iNES_Ram(icart *cart, u8 wait) {
     ines_cart *c = (ines_cart *)cart;
-    u16 index = ((address - 0x8000) / INES_PRG_PAGE_SIZE) % c->prg_pages;
-    return c->prg_rom[index][(address - 0x8000) % INES_PRG_PAGE_SIZE];
+    msync(c->prg_ram, INES_PRG_RAM_SIZE, wait ? MS_SYNC : MS_ASYNC);
 }
-static u8 Read_iNES0_Chr(icart *cart, u16 address) {
+
+/* Board state: PRG RAM, then CHR RAM, then the cartridge struct itself
+ * (the mapper's registers and its bank windows).  The struct's pointers
+ * are the same for every copy, so it is copied back over itself whole. */
+#define STATE_PRG_RAM   0
+#define STATE_CHR_RAM   INES_PRG_RAM_SIZE
+#define STATE_REGS      (STATE_CHR_RAM + INES_CHR_PAGE_SIZE)
+
+static void Save_iNES_State(icart *cart, u8 *state) {
     ines_cart *c = (ines_cart *)cart;
-    u16 index = (address / INES_CHR_PAGE_SIZE);
-    return c->chr_rom[index][address % INES_PRG_PAGE_SIZE];
+
+    memcpy(state + STATE_PRG_RAM, c->prg_ram, INES_PRG_RAM_SIZE);
+    if (c->chr_ram) {
+        memcpy(state + STATE_CHR_RAM, c->chr_ram, INES_CHR_PAGE_SIZE);
+    }
+    memcpy(state + STATE_REGS, c, Find_iNES_Mapper(c->mapper_id)->size);
 }
 
-static u8 Write_iNES0_Prg(icart *cart, u16 address, u8 value) {
-    return 0;
+static void Load_iNES_State(icart *cart, const u8 *state) {
+    ines_cart *c = (ines_cart *)cart;
+    register u8 i;
+
+    memcpy(c, state + STATE_REGS, Find_iNES_Mapper(c->mapper_id)->size);
+    memcpy(c->prg_ram, state + STATE_PRG_RAM, INES_PRG_RAM_SIZE);
+    if (c->chr_ram) {
+        memcpy(c->chr_ram, state + STATE_CHR_RAM, INES_CHR_PAGE_SIZE);
+        Decode_Chr_Tiles(c->chr_tiles, c->chr_ram, TILES_PER_PAGE);
+    }
+    for (i = 0; i < INES_PRG_WINDOWS; i++) {
+        Mem_Map_Prg(0x8000 + i * INES_PRG_BANK_SIZE, INES_PRG_BANK_SIZE,
+                    c->prg_bank[i]);
+    }
 }
-static u8 Write_iNES0_Chr(icart *cart, u16 address, u8 value) {
-    return 0;
+
+/* Func: void Switch_iNES_Prg(ines_cart *c, u8 window, u16 bank)
+ * Desc: Has the 8K at $8000 + window * 8K read from the given 8K bank
+ *       of PRG ROM.  Decoded code of the old bank is dropped lazily by
+ *       the CPU core (see Find_Block). */
+void Switch_iNES_Prg(ines_cart *c, u8 window, u16 bank) {
+    register u8 *data;
+
+    if (!c->prg_pages) return;
+    bank %= c->prg_pages * PRG_BANKS_PER_PAGE;
+    data = c->prg_rom[bank / PRG_BANKS_PER_PAGE] +
+           (bank % PRG_BANKS_PER_PAGE) * INES_PRG_BANK_SIZE;
+    if (c->prg_bank[window] == data) return;
+
+    c->prg_bank[window] = data;
+    Mem_Map_Prg(0x8000 + window * INES_PRG_BANK_SIZE, INES_PRG_BANK_SIZE,
+                data);
+}
+
+/* Func: void Switch_iNES_Chr(ines_cart *c, u8 window, u16 bank)
+ * Desc: Has the 1K at window * 1K of the pattern tables read from the
+ *       given 1K bank of CHR ROM (or CHR RAM). */
+void Switch_iNES_Chr(ines_cart *c, u8 window, u16 bank) {
+    register u8 *data;
+
+    if (c->chr_ram) {
+        bank %= CHR_BANKS_PER_PAGE;
+        data = c->chr_ram + bank * INES_CHR_BANK_SIZE;
+    } else if (c->chr_pages) {
+        bank %= c->chr_pages * CHR_BANKS_PER_PAGE;
+        data = c->chr_rom[bank / CHR_BANKS_PER_PAGE] +
+               (bank % CHR_BANKS_PER_PAGE) * INES_CHR_BANK_SIZE;
+    } else {
+        return;
+    }
+    if (c->chr_bank[window] == data) return;
+
+    c->chr_bank[window] = data;
+    Ppu_Map_Chr(window, data, c->chr_tiles + bank * TILES_PER_BANK);
+}
+
+static u8 Read_iNES_Prg(icart *cart, u16 address) {
+    ines_cart *c = (ines_cart *)cart;
+    if (address >= 0x6000 && address < 0x8000) {
+        return c->prg_ram[address & (INES_PRG_RAM_SIZE - 1)];
+    }
+    if (address < 0x8000 || !c->prg_pages) return 0;
+    return c->prg_bank[(address >> 13) & 0x03]
+                      [address & (INES_PRG_BANK_SIZE - 1)];
+}
+
+/* Only CHR RAM can be written.  The row of the tile it lands in is
+ * decoded again right away, so reads never check for stale tiles. */
+static u8 Write_iNES_Chr(icart *cart, u16 address, u8 value) {
+    ines_cart *c = (ines_cart *)cart;
+    register u16 offset;
+
+    if (!c->chr_ram) return 0;
+    address &= 0x1FFF;
+    offset = (c->chr_bank[address >> 10] - c->chr_ram) +
+             (address & (INES_CHR_BANK_SIZE - 1));
+    c->chr_ram[offset] = value;
+    Decode_Chr_Row(c->chr_tiles + offset / CHR_TILE_BYTES,
+                   c->chr_ram + (offset & ~(CHR_TILE_BYTES - 1)),
+                   offset & 0x07);
+    return 1;
 }
 
-static void Unload_iNES0(icart *cart) {
+static void Unload_iNES(icart *cart) {
     ines_cart *c = (ines_cart *)cart;
+    Mem_Map_Prg(0x8000, 0x8000, 0);
+    Unmap_iNES_Prg_Ram(c);
     Free_iNES_Pages(c);
     free(c);
 }
@@ -0,0 +1,283 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: ines-mappers.c
+ *
+ * Description:
+ *
+ *      iNES mappers: NROM, MMC1, UxROM, CNROM and MMC3.  Each one is a
+ *      Reset function that sets up the power-on banks and a register
+ *      write handler; both only repoint the cartridge's bank windows
+ *      (Switch_iNES_Prg/Chr), so reads cost the same for every mapper.
+ *      Register writes reach a mapper after the PPU was caught up (see
+ *      Mem_Set_Io), so CHR and mirroring may change right away.
+ *
+ *      MMC3's scanline counter is clocked by the PPU as it catches up,
+ *      and the cycle its IRQ fires at is predicted from the PPU's
+ *      setup and scheduled (SCHED_MAPPER_IRQ), so the CPU runs freely
+ *      up to it instead of the PPU being stepped every line.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#include "ines-mappers.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "sched.h"
+
+/* Banks larger than a window */
+static void Switch_Prg16(ines_cart *c, u8 window, u16 bank) {
+    Switch_iNES_Prg(c, window * 2, bank * 2);
+    Switch_iNES_Prg(c, window * 2 + 1, bank * 2 + 1);
+}
+
+static void Switch_Chr4(ines_cart *c, u8 window, u16 bank) {
+    register u8 i;
+    for (i = 0; i < 4; i++) Switch_iNES_Chr(c, window * 4 + i, bank * 4 + i);
+}
+
+static void Switch_Chr8(ines_cart *c, u16 bank) {
+    Switch_Chr4(c, 0, bank * 2);
+    Switch_Chr4(c, 1, bank * 2 + 1);
+}
+
+/* NROM: up to 32K of PRG and 8K of CHR, no registers.  16K of PRG shows
+ * up at both $8000 and $C000. */
+static void Reset_NROM(ines_cart *c) {
+    Switch_Prg16(c, 0, 0);
+    Switch_Prg16(c, 1, 1);
+    Switch_Chr8(c, 0);
+}
+
+static u8 Write_NROM(icart *cart, u16 address, u8 value) {
+    return 0;
+}
+
+/* MMC1: writes with bit 7 set clear the shift register, any other write
+ * shifts in bit 0; the fifth one loads the register picked by bits
+ * 13-14 of its address. */
+#define MMC1_PRG_MODE(control)  (((control) >> 2) & 0x03)
+#define MMC1_CHR_4K             0x10
+
+static void Update_MMC1(mmc1_cart *c) {
+    static const u8 mirroring[] = {
+        MIRROR_SINGLE_LOW, MIRROR_SINGLE_HIGH,
+        MIRROR_VERTICAL, MIRROR_HORIZONTAL
+    };
+    ines_cart *ic = (ines_cart *)c;
+
+    Set_Nametable_Mirroring(mirroring[c->control & 0x03]);
+    switch (MMC1_PRG_MODE(c->control)) {
+        case 0: case 1:     /* 32K at $8000 */
+            Switch_Prg16(ic, 0, c->prg & 0x0E);
+            Switch_Prg16(ic, 1, (c->prg & 0x0E) | 1);
+            break;
+        case 2:             /* First bank fixed at $8000 */
+            Switch_Prg16(ic, 0, 0);
+            Switch_Prg16(ic, 1, c->prg & 0x0F);
+            break;
+        case 3:             /* Last bank fixed at $C000 */
+            Switch_Prg16(ic, 0, c->prg & 0x0F);
+            Switch_Prg16(ic, 1, ic->prg_pages - 1);
+            break;
+    }
+    if (c->control & MMC1_CHR_4K) {
+        Switch_Chr4(ic, 0, c->chr[0]);
+        Switch_Chr4(ic, 1, c->chr[1]);
+    } else {
+        Switch_Chr4(ic, 0, c->chr[0] & 0x1E);
+        Switch_Chr4(ic, 1, c->chr[0] | 1);
+    }
+}
+
+static void Reset_MMC1(ines_cart *cart) {
+    mmc1_cart *c = (mmc1_cart *)cart;
+    c->control = 0x0C;
+    Update_MMC1(c);
+}
+
+static u8 Write_MMC1(icart *cart, u16 address, u8 value) {
+    mmc1_cart *c = (mmc1_cart *)cart;
+
+    if (address < 0x8000) return 0;
+    if (value & 0x80) {
+        c->shift = c->count = 0;
+        c->control |= 0x0C;
+        Update_MMC1(c);
+        return 1;
+    }
+    c->shift |= (value & 1) << c->count;
+    if (++c->count < 5) return 1;
+
+    switch ((address >> 13) & 0x03) {
+        case 0: c->control = c->shift; break;
+        case 1: c->chr[0] = c->shift; break;
+        case 2: c->chr[1] = c->shift; break;
+        case 3: c->prg = c->shift; break;
+    }
+    c->shift = c->count = 0;
+    Update_MMC1(c);
+    return 1;
+}
+
+/* UxROM: 16K switched at $8000, last 16K fixed at $C000 */
+static void Reset_UxROM(ines_cart *c) {
+    Switch_Prg16(c, 0, 0);
+    Switch_Prg16(c, 1, c->prg_pages - 1);
+    Switch_Chr8(c, 0);
+}
+
+static u8 Write_UxROM(icart *cart, u16 address, u8 value) {
+    if (address < 0x8000) return 0;
+    Switch_Prg16((ines_cart *)cart, 0, value);
+    return 1;
+}
+
+/* CNROM: fixed PRG, 8K of CHR switched */
+static void Reset_CNROM(ines_cart *c) {
+    Reset_NROM(c);
+}
+
+static u8 Write_CNROM(icart *cart, u16 address, u8 value) {
+    if (address < 0x8000) return 0;
+    Switch_Chr8((ines_cart *)cart, value);
+    return 1;
+}
+
+/* MMC3: eight bank registers behind a select register.  R6 sits at
+ * $8000 or (PRG swap) $C000 with the second-last bank at the other;
+ * CHR inversion swaps the 2K banks of R0-R1 with the 1K ones of R2-R5.
+ * Registers are decoded by A0 and A13-A14. */
+#define MMC3_PRG_SWAP   0x40
+#define MMC3_CHR_INVERT 0x80
+
+static void Update_MMC3(mmc3_cart *c) {
+    ines_cart *ic = (ines_cart *)c;
+    register u8 prg = (c->select & MMC3_PRG_SWAP) ? 2 : 0;
+    register u8 chr = (c->select & MMC3_CHR_INVERT) ? 4 : 0;
+    register u16 last = ic->prg_pages * 2 - 1;
+    register u8 i;
+
+    Switch_iNES_Prg(ic, 0 ^ prg, c->reg[6]);
+    Switch_iNES_Prg(ic, 1, c->reg[7]);
+    Switch_iNES_Prg(ic, 2 ^ prg, last - 1);
+    Switch_iNES_Prg(ic, 3, last);
+
+    Switch_iNES_Chr(ic, 0 ^ chr, c->reg[0] & 0xFE);
+    Switch_iNES_Chr(ic, 1 ^ chr, c->reg[0] | 1);
+    Switch_iNES_Chr(ic, 2 ^ chr, c->reg[1] & 0xFE);
+    Switch_iNES_Chr(ic, 3 ^ chr, c->reg[1] | 1);
+    for (i = 0; i < 4; i++) Switch_iNES_Chr(ic, (4 + i) ^ chr, c->reg[2 + i]);
+}
+
+/* The loaded MMC3, for the PPU and scheduler hooks */
+static mmc3_cart *mmc3;
+
+/* PPU A12 rise: the counter is reloaded when it is 0 or a reload was
+ * asked for, otherwise counted down; reaching 0 raises the IRQ. */
+static void Clock_MMC3(void) {
+    if (!mmc3->irq_counter || mmc3->irq_reload) {
+        mmc3->irq_counter = mmc3->irq_latch;
+        mmc3->irq_reload = 0;
+    } else {
+        mmc3->irq_counter--;
+    }
+    if (!mmc3->irq_counter && mmc3->irq_enabled) Cpu_Irq(CPU_IRQ_MAPPER);
+}
+
+static void Irq_MMC3(void);
+
+/* Schedules SCHED_MAPPER_IRQ for the rise that takes the counter to 0.
+ * Where that is only a lower bound (see Ppu_A12_Rise_At), the event
+ * just predicts again. */
+static void Predict_MMC3_Irq(void) {
+    register u32 n;
+
+    if (!mmc3->irq_enabled) {
+        Sched_Cancel(SCHED_MAPPER_IRQ);
+        return;
+    }
+    n = (!mmc3->irq_counter || mmc3->irq_reload) ? mmc3->irq_latch + 1u
+                                                 : mmc3->irq_counter;
+    Sched_Set(SCHED_MAPPER_IRQ, Ppu_A12_Rise_At(n), Irq_MMC3);
+}
+
+/* SCHED_MAPPER_IRQ: the PPU clocks the counter as it catches up */
+static void Irq_MMC3(void) {
+    Ppu_Sync();
+    Predict_MMC3_Irq();
+}
+
+static void Reset_MMC3(ines_cart *cart) {
+    mmc3_cart *c = (mmc3_cart *)cart;
+    c->reg[7] = 1;
+    Update_MMC3(c);
+    mmc3 = c;
+    Ppu_Set_A12_Hook(Clock_MMC3, Predict_MMC3_Irq);
+}
+
+static u8 Write_MMC3(icart *cart, u16 address, u8 value) {
+    mmc3_cart *c = (mmc3_cart *)cart;
+
+    switch (address & 0xE001) {
+        case 0x8000:
+            c->select = value;
+            break;
+        case 0x8001:
+            c->reg[c->select & 0x07] = value;
+            break;
+        case 0xA000:
+            /* Four-screen boards ignore it */
+            if ((c->flags & INES_MIRROR_MASK) < MIRROR_FOUR_SCREEN) {
+                Set_Nametable_Mirroring((value & 1) ? MIRROR_HORIZONTAL
+                                                    : MIRROR_VERTICAL);
+            }
+            return 1;
+        case 0xC000:
+            c->irq_latch = value;
+            Predict_MMC3_Irq();
+            return 1;
+        case 0xC001:
+            c->irq_counter = 0;
+            c->irq_reload = 1;
+            Predict_MMC3_Irq();
+            return 1;
+        case 0xE000:
+            c->irq_enabled = 0;
+            Cpu_Ack_Irq(CPU_IRQ_MAPPER);
+            Predict_MMC3_Irq();
+            return 1;
+        case 0xE001:
+            c->irq_enabled = 1;
+            Predict_MMC3_Irq();
+            return 1;
+        default:
+            /* $A001 (PRG RAM enable and protect, not emulated: see
+             * Mem_Map_Prg_Ram), or below $8000 */
+            return 0;
+    }
+    Update_MMC3(c);
+    return 1;
+}
+
+#define MAPPER_ENTRY(id, name, type)                                   \
+    { id, #name, sizeof(type), Reset_##name, Write_##name },
+static const ines_mapper mappers[] = {
+    INES_MAPPER_LIST(MAPPER_ENTRY)
+};
+#undef MAPPER_ENTRY
+
+#define MAPPER_COUNT (sizeof(mappers) / sizeof(mappers[0]))
+
+/* Func: const ines_mapper *Find_iNES_Mapper(u8 id)
+ * Desc: Looks up a mapper in the registry by its iNES number. */
+const ines_mapper *Find_iNES_Mapper(u8 id) {
+    register u32 i;
+    for (i = 0; i < MAPPER_COUNT; i++) {
+        if (mappers[i].id == id) return &mappers[i];
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: lanecheck.c
+ *
+ * Description:
+ *
+ *      Checks the lockstep core (cpu-lanes.h) against the scalar one.
+ *      A ROM is powered on in every lane, each with different internal
+ *      RAM (which is undefined at power-on), and run for some frames
+ *      the way a batch runner would: lanes run in lockstep, and each
+ *      one that stops is swapped into the scalar emulator for a slice
+ *      of Cpu_Steps.  Then each lane's power-on state is run again on its
+ *      own, by Cpu_Step alone, and the two machines are compared.
+ *
+ *      Usage: lanecheck <rom> [frames]
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "types.h"
+#include "cpu.h"
+#include "ppu.h"
+#include "mem.h"
+#include "cart.h"
+#include "cpu-lanes.h"
+
+#define DEFAULT_FRAMES  60
+
+/* CPU cycles in an NTSC frame (341 dots, 262 lines) */
+#define FRAME_CYCLES    29781
+
+extern cpu_6502 cpu;
+
+/* The lanes, and a copy of them at power-on for the scalar runs */
+static cpu_lanes lanes;
+static cpu_lanes start;
+
+/* ppu.c logs through the debugger, which isn't linked in */
+void Log_Line(const char *format, ...) {
+}
+
+/* Powers the console on into a lane, with internal RAM filled from a
+ * generator seeded by the lane */
+static void Power_On(u8 lane) {
+    u8 ram[INTERNAL_MEM_SIZE];
+    register u32 i, x = 0x9E3779B9u * (lane + 1);
+
+    Cpu_Init();
+    Ppu_Init();
+    Mem_Init();
+    for (i = 0; i < INTERNAL_MEM_SIZE; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        ram[i] = (u8)x;
+    }
+    Mem_Write_Block(0, ram, INTERNAL_MEM_SIZE);
+    cpu.cycles = 0;
+    Ppu_Resync();
+    Lanes_Store(&lanes, lane);
+}
+
+/* Runs every lane until it has run for end cycles.  A lane that stops
+ * is run by the scalar emulator for a slice, since code making one
+ * access lanes can't make (polling PPUSTATUS, say) tends to make more;
+ * lanes that are done are left idle. */
+static void Run_Lanes(u64 end) {
+    register u32 l, budget, stopped;
+    register u64 stop;
+    register u8 running;
+
+    for (;;) {
+        budget = FRAME_CYCLES;
+        running = 0;
+        for (l = 0; l < CPU_LANES; l++) {
+            if (LANE_RUNNING != lanes.state[l]) continue;
+            if (lanes.cycles[l] >= end) {
+                lanes.state[l] = LANE_IDLE;
+            } else {
+                running = 1;
+                if (end - lanes.cycles[l] < budget) budget = end - lanes.cycles[l];
+            }
+        }
+        stopped = running ? Lanes_Exec(&lanes, budget) : 0;
+        if (!running && !stopped) break;
+
+        for (l = 0; l < CPU_LANES; l++) {
+            if (!(stopped & (1 << l))) continue;
+            Lanes_Load(&lanes, l);
+            stop = cpu.cycles + CPU_RUN_SLICE;
+            if (stop > end) stop = end;
+            while (cpu.cycles < stop) Cpu_Step();
+            Lanes_Store(&lanes, l);
+        }
+    }
+
+    /* Lanes keep their PPU where it was last stored; catch each up */
+    for (l = 0; l < CPU_LANES; l++) {
+        Lanes_Load(&lanes, l);
+        Lanes_Store(&lanes, l);
+    }
+}
+
+/* Runs a lane's power-on state on its own, into start */
+static void Run_Scalar(u8 lane, u64 end) {
+    Lanes_Load(&start, lane);
+    while (cpu.cycles < end) Cpu_Step();
+    Lanes_Store(&start, lane);
+}
+
+/* Reports where lane of a and b differ, if they do.  Returns 1 if
+ * they do. */
+static u8 Compare_Lane(const cpu_lanes *a, const cpu_lanes *b, u8 lane) {
+    const ppu_2c02 *pa = &a->ppu[lane], *pb = &b->ppu[lane];
+    register u32 i;
+
+    if (a->pc[lane] != b->pc[lane] || a->a[lane] != b->a[lane] ||
+        a->x[lane] != b->x[lane] || a->y[lane] != b->y[lane] ||
+        a->p[lane] != b->p[lane] || a->s[lane] != b->s[lane] ||
+        a->cycles[lane] != b->cycles[lane]) {
+        printf("lane %2u: CPU differs: PC %04X/%04X A %02X/%02X "
+               "X %02X/%02X Y %02X/%02X P %02X/%02X S %02X/%02X "
+               "cycles %llu/%llu\n", lane,
+               a->pc[lane], b->pc[lane], a->a[lane], b->a[lane],
+               a->x[lane], b->x[lane], a->y[lane], b->y[lane],
+               a->p[lane], b->p[lane], a->s[lane], b->s[lane],
+               (unsigned long long)a->cycles[lane],
+               (unsigned long long)b->cycles[lane]);
+        return 1;
+    }
+    for (i = 0; i < LANE_RAM_SIZE; i++) {
+        if (a->ram[i][lane] != b->ram[i][lane]) {
+            printf("lane %2u: RAM differs at %04X: %02X/%02X\n", lane, i,
+                   a->ram[i][lane], b->ram[i][lane]);
+            return 1;
+        }
+    }
+    if (pa->scanline != pb->scanline || pa->cycles != pb->cycles ||
+        pa->frame != pb->frame || pa->status != pb->status ||
+        pa->ctrl != pb->ctrl || pa->mask != pb->mask ||
+        pa->v_addr != pb->v_addr || pa->t_addr != pb->t_addr ||
+        memcmp(pa->nt, pb->nt, sizeof(pa->nt)) ||
+        memcmp(pa->oam, pb->oam, sizeof(pa->oam)) ||
+        memcmp(pa->bg_pal, pb->bg_pal, sizeof(pa->bg_pal)) ||
+        memcmp(pa->spr_pal, pb->spr_pal, sizeof(pa->spr_pal))) {
+        printf("lane %2u: PPU differs (frame %u/%u, line %d/%d)\n", lane,
+               pa->frame, pb->frame, pa->scanline, pb->scanline);
+        return 1;
+    }
+    if (memcmp(a->cart[lane], b->cart[lane], CART_STATE_SIZE)) {
+        printf("lane %2u: cartridge differs\n", lane);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    register u32 l, frames, bad = 0;
+    register u64 end;
+    clock_t t0, t1, t2;
+
+    if (argc < 2) {
+        printf("Usage: %s <rom> [frames]\n", argv[0]);
+        return 2;
+    }
+    frames = (argc > 2) ? atoi(argv[2]) : DEFAULT_FRAMES;
+    end = (u64)frames * FRAME_CYCLES;
+
+    Load_Cartridge(argv[1]);
+    for (l = 0; l < CPU_LANES; l++) Power_On(l);
+    start = lanes;
+
+    t0 = clock();
+    Run_Lanes(end);
+    t1 = clock();
+    for (l = 0; l < CPU_LANES; l++) Run_Scalar(l, end);
+    t2 = clock();
+
+    for (l = 0; l < CPU_LANES; l++) bad += Compare_Lane(&lanes, &start, l);
+    printf("%u lanes, %u frames: %u differ (lanes %.2fs, scalar %.2fs)\n",
+           CPU_LANES, frames, bad, (double)(t1 - t0) / CLOCKS_PER_SEC,
+           (double)(t2 - t1) / CLOCKS_PER_SEC);
+    Unload_Cartridge();
+    return bad ? 1 : 0;
+}
@@ -1,5 +1,37 @@
 #include "cart.h"
 #include "icart.h"
+#include "chr-tiles.h"
+#include "sched.h"
+
+/* Called by Load_iNES; loadtest has no PPU or CPU memory map */
+void Set_Nametable_Mirroring(u8 mode) {
+}
+
+void Mem_Map_Prg(u16 address, u16 length, const u8 *data) {
+}
+
+void Mem_Map_Prg_Ram(u8 *data) {
+}
+
+void Ppu_Map_Chr(u8 page, u8 *data, const chr_tile *tiles) {
+}
+
+/* Called by the MMC3 IRQ counter, which never runs here */
+void Ppu_Set_A12_Hook(void (*clock)(void), void (*retime)(void)) {
+}
+
+u64 Ppu_A12_Rise_At(u32 n) {
+    return SCHED_NEVER;
+}
+
+void Ppu_Sync(void) {
+}
+
+void Cpu_Irq(u8 source) {
+}
+
+void Cpu_Ack_Irq(u8 source) {
+}
 
 int main(int argc, char **argv) {
     Load_Cartridge(argv[1]);
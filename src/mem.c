@@ -17,29 +17,51 @@
 #include "ppu.h"
 #include "bitwise.h"
 #include "cart.h"
+#include "cpu.h"
 #include <string.h>
 
-#define INTERNAL_MEM_SIZE 0x800
+#define RAM_END         0x2000
 
 static const u8 INTERNAL_MEM_INIT[] = {0xF7, 0xEF, 0xDF, 0xFF, 0xFF, 0xFF, 0xFF, 0xBF};
 
-static u8 internal_mem[INTERNAL_MEM_SIZE];
+u8 internal_mem[INTERNAL_MEM_SIZE];
+
+/* One bit per byte of internal RAM that the CPU core has decoded into a
+ * block.  Writing such a byte invalidates the block. */
+u8 ram_code_map[INTERNAL_MEM_SIZE >> 3];
+
+/* Reads from a page with a pointer here come straight from it: internal
+ * RAM and its mirrors, and PRG ROM as the cartridge maps it in.  Every
+ * other page (I/O, or anything the mapper has to see) goes through
+ * Mem_Fetch_Io. */
+const u8 *mem_read_map[MEM_PAGES];
+
+/* The cartridge's PRG RAM (see Mem_Map_Prg_Ram), and whether it was
+ * written since it was last synced */
+static u8 *prg_ram;
+static u8 prg_ram_dirty;
 
 
 /* Begin Functions */
 
-INLINED void Mem_Init(void) {
+void Mem_Init(void) {
+    register u16 page;
+
     memset(internal_mem, 0xFF, INTERNAL_MEM_SIZE);
     memcpy(internal_mem + 8, INTERNAL_MEM_INIT, 8);
+    for (page = 0; page < (RAM_END >> MEM_PAGE_SHIFT); page++) {
+        mem_read_map[page] = internal_mem + ((page << MEM_PAGE_SHIFT) % INTERNAL_MEM_SIZE);
+    }
     neslog("Memory initialized.\n");
 }
 
-INLINED void Mem_Reset(void) {
+void Mem_Reset(void) {
     neslog("Memory reset.\n");
 }
 
-INLINED u8 Mem_Fetch(u16 address) {
-    /* Memory mapping should go here, as things are implemented. */
+/* Func: u8 Mem_Fetch_Io(u16 address)
+ * Desc: Mem_Fetch for pages without a pointer in mem_read_map. */
+u8 Mem_Fetch_Io(u16 address) {
     if (address < 0x2000) return internal_mem[address % INTERNAL_MEM_SIZE];
     else if (address > 0x4020) return Read_Cartridge_Prg(address);
     else if (address < 0x2008) return Read_Ppu(address);
@@ -49,30 +71,170 @@ INLINED u8 Mem_Fetch(u16 address) {
     return 0x00;
 }
 
-INLINED u16 Mem_Fetch16(u16 address) {
-    /* Don't forget to test page wraparounds */
-    return TO_U16(Mem_Fetch(address), Mem_Fetch(address + 1));
+/* Func: void Mem_Map_Prg(u16 address, u16 length, const u8 *data)
+ * Desc: Has reads of length bytes from address (both multiples of the
+ *       page size, in $6000-$FFFF) come straight from data, or from
+ *       the cartridge's read handler again if data is 0.  Called by
+ *       mappers when they load and whenever they switch banks. */
+void Mem_Map_Prg(u16 address, u16 length, const u8 *data) {
+    register u16 page = address >> MEM_PAGE_SHIFT;
+    register u16 i;
+
+    for (i = 0; i < (length >> MEM_PAGE_SHIFT); i++) {
+        mem_read_map[page + i] = data ? data + (i << MEM_PAGE_SHIFT) : 0;
+    }
+    Cpu_Flush_Fetch();
+}
+
+/* Func: void Mem_Map_Prg_Ram(u8 *data)
+ * Desc: Has reads and writes of $6000-$7FFF go straight to the given
+ *       8K of PRG RAM, or to the cartridge again if data is 0.  Mapped
+ *       RAM is always enabled and writable; the MMC1 and MMC3 enable
+ *       and write-protect bits are not emulated. */
+void Mem_Map_Prg_Ram(u8 *data) {
+    prg_ram = data;
+    prg_ram_dirty = 0;
+    Mem_Map_Prg(0x6000, 0x2000, data);
+}
+
+/* Func: void Mem_Sync_Prg_Ram(void)
+ * Desc: Has the cartridge write PRG RAM back (see Sync_Cartridge_Ram)
+ *       if it changed since the last time.  Called once a frame, so a
+ *       game writing its save costs no system calls per write. */
+void Mem_Sync_Prg_Ram(void) {
+    if (!prg_ram_dirty) return;
+    prg_ram_dirty = 0;
+    Sync_Cartridge_Ram(0);
 }
 
-INLINED void Mem_Set(u16 address, u8 value) {
-    /* Memory Mapping and the whatnot */
-    if (address < 0x2000) internal_mem[address % INTERNAL_MEM_SIZE] = value;
-    else if (address < 0x2008) {
+/* CPU cycles OAM DMA stalls for, one more if it starts on an odd one */
+#define OAM_DMA_CYCLES  513
+
+/* OAMDMA: the page is copied to OAM in one go, straight from where it
+ * is mapped where it can be, and the stall charged all at once when
+ * the store ends (Cpu_Stall) */
+static void Oam_Dma(u8 page) {
+    register const u8 *data = Mem_Get_Page(page << 8);
+    register u32 i;
+    u8 buffer[0x100];
+
+    if (!data) {
+        for (i = 0; i < 0x100; i++) buffer[i] = Mem_Fetch((page << 8) | i);
+        data = buffer;
+    }
+    Ppu_Oam_Dma(data);
+    Cpu_Stall(OAM_DMA_CYCLES);
+}
+
+/* Func: void Mem_Set_Io(u16 address, u8 value)
+ * Desc: Mem_Set for anything but internal RAM. */
+void Mem_Set_Io(u16 address, u8 value) {
+    if (address < 0x2008) {
         Write_Ppu(address, value);
+    } else if (prg_ram && address >= 0x6000 && address < 0x8000) {
+        prg_ram[address & 0x1FFF] = value;
+        prg_ram_dirty = 1;
+    } else if (OAMDMA == address) {
+        Oam_Dma(value);
+    } else if (address > 0x4020) {
+        /* Mapper registers may switch CHR banks or mirroring */
+        Ppu_Sync();
+        Write_Cartridge_Prg(address, value);
     } else {
         //printf("Unassigned memory partition mapped: 0x%04X\n", address);
     }
 }
 
-INLINED void Mem_Set16(u16 address, u16 value) {
+void Mem_Set16(u16 address, u16 value) {
     Mem_Set(address, LB(value));
     Mem_Set(address + 1, UB(value));
 }
 
-INLINED u8 *Mem_Get_Ptr(u16 address) {
+u8 *Mem_Get_Ptr(u16 address) {
     return &(internal_mem[address % INTERNAL_MEM_SIZE]);
 }
 
+void Mem_Mark_Code(u16 offset, u8 length, u8 is_code) {
+    for (; length && offset < INTERNAL_MEM_SIZE; length--, offset++) {
+        if (is_code) FLAG_SET(ram_code_map[offset >> 3], 1 << (offset & 7));
+        else FLAG_CLEAR(ram_code_map[offset >> 3], 1 << (offset & 7));
+    }
+}
+
+void Mem_Clear_Code_Map(void) {
+    memset(ram_code_map, 0, sizeof(ram_code_map));
+}
+
+/* Used by generated code, which tests the map itself after RAM writes */
+const u8 *Mem_Get_Code_Map(void) {
+    return ram_code_map;
+}
+
+/* Does any of the length bytes of internal RAM from address hold
+ * decoded code? */
+u8 Mem_Is_Code(u16 address, u16 length) {
+    for (; length; length--, address++) {
+        address %= INTERNAL_MEM_SIZE;
+        if (IS_SET(ram_code_map[address >> 3], 1 << (address & 7))) return 1;
+    }
+    return 0;
+}
+
+/* Bulk access to internal RAM, for loops the CPU core runs in one go.
+ * Ranges may cross mirrors but must lie below $2000; writes have the
+ * same effect as a Mem_Set per byte. */
+static void Invalidate_Code_Range(u16 address, u16 length) {
+    for (; length; length--, address++) {
+        address %= INTERNAL_MEM_SIZE;
+        if (IS_SET(ram_code_map[address >> 3], 1 << (address & 7))) {
+            Cpu_Invalidate_Code(address);
+        }
+    }
+}
+
+void Mem_Fill(u16 address, u8 value, u16 length) {
+    register u16 offset, n;
+    u16 first = address, count = length;
+
+    for (; length; address += n, length -= n) {
+        offset = address % INTERNAL_MEM_SIZE;
+        n = INTERNAL_MEM_SIZE - offset;
+        if (n > length) n = length;
+        memset(internal_mem + offset, value, n);
+    }
+    Invalidate_Code_Range(first, count);
+}
+
+void Mem_Write_Block(u16 address, const u8 *src, u16 length) {
+    register u16 offset, n;
+    u16 first = address, count = length;
+
+    for (; length; address += n, src += n, length -= n) {
+        offset = address % INTERNAL_MEM_SIZE;
+        n = INTERNAL_MEM_SIZE - offset;
+        if (n > length) n = length;
+        memcpy(internal_mem + offset, src, n);
+    }
+    Invalidate_Code_Range(first, count);
+}
+
+/* Same as a Mem_Fetch per byte.  Only internal RAM is copied in one go;
+ * anything else should be free of read side effects. */
+void Mem_Read_Block(u8 *dst, u16 address, u16 length) {
+    register u16 offset, n;
+
+    if ((u32)address + length > 0x2000) {
+        for (; length; length--) *dst++ = Mem_Fetch(address++);
+        return;
+    }
+    for (; length; address += n, dst += n, length -= n) {
+        offset = address % INTERNAL_MEM_SIZE;
+        n = INTERNAL_MEM_SIZE - offset;
+        if (n > length) n = length;
+        memcpy(dst, internal_mem + offset, n);
+    }
+}
+
 /* Dumps all of memory.  ALL of it. */
 void Mem_Dump(void) {
     u16 address = 0;
@@ -29,33 +29,33 @@ const u8 mode_length[] = {
 
 
 /* Define the function prototypes */
-#define OP(name, mode, cycles) void Do_##name(u8 opcode);
+#define OP(code, name, mode, cycles) void Do_##name(u8 opcode);
 OPCODE_LIST(OP)
 #undef OP
 
 /* Define the jump table */
-#define OP(name, mode, cycles) Do_##name,
+#define OP(code, name, mode, cycles) Do_##name,
 const op_func op_fn[] = {
     OPCODE_LIST(OP)
 };
 #undef OP
 
 /* Define the cycle table (for cycle-accurate emulation) */
-#define OP(name, mode, cycles) cycles,
+#define OP(code, name, mode, cycles) cycles,
 const static u32 op_cyc[] = {
     OPCODE_LIST(OP)
 };
 #undef OP
 
 /* Define addressing mode table */
-#define OP(name, mode, cycles) mode,
+#define OP(code, name, mode, cycles) mode,
 const u8 op_mode[] = {
     OPCODE_LIST(OP)
 };
 #undef OP
 
 /* Define the string table of opcodes, for debugging purposes */
-#define OP(name, mode, cycles) #name,
+#define OP(code, name, mode, cycles) #name,
 const char *op_str[] = {
     OPCODE_LIST(OP)
 };
@@ -99,6 +99,18 @@ extern cpu_6502 cpu;
 
 #define STACK_PAGE 0x0100
 
+/* Zero page modes can only reach internal RAM, so they skip the memory
+ * map.  READ_AT/WRITE_AT access an address the current opcode's mode
+ * produced. */
+#define IN_ZERO_PAGE(mode) (ZP == (mode) || ZX == (mode) || ZY == (mode))
+#define READ_AT(addr)                                                  \
+    (IN_ZERO_PAGE(MODE) ? MEM_FETCH_RAM(addr) : Mem_Fetch(addr))
+#define WRITE_AT(addr, v)                                              \
+    do {                                                               \
+        if (IN_ZERO_PAGE(MODE)) MEM_SET_RAM(addr, v);                  \
+        else Mem_Set(addr, v);                                         \
+    } while (0)
+
 #define GET(flag) FLAG_GET(P, flag)
 #define SET(flags) FLAG_SET(P, flags)
 #define CLR(flags) FLAG_CLEAR(P, flags)
@@ -159,11 +171,11 @@ static u16 Opcode_Get_Address(u8 mode, u8 cross) {
 			return Mem_Fetch16(addr);
 		break;
 		case IX:
-			return TO_U16(Mem_Fetch((u16)((op1 + X) % 0x0100)), Mem_Fetch((u16)((op1 + X + 1) % 0x0100)));
+			return TO_U16(MEM_FETCH_RAM((u8)(op1 + X)), MEM_FETCH_RAM((u8)(op1 + X + 1)));
 		break;
 		case IY:
 			/* Check for page crossing */
-			addr = TO_U16(Mem_Fetch(((u16)(op1)) % 0x0100), Mem_Fetch(((u16)(op1 + 1)) % 0x0100));
+			addr = TO_U16(MEM_FETCH_RAM(op1), MEM_FETCH_RAM((u8)(op1 + 1)));
 			if (cross && (PAGE_OF(addr) != PAGE_OF(addr + Y))) {
 				Cpu_Add_Cycles(1);
 			}
@@ -184,7 +196,7 @@ static u8 Opcode_Get_Value(u8 mode, u8 cross) {
 			return A;
 		default:
 			addr = Opcode_Get_Address(mode, cross);
-			return Mem_Fetch(addr);
+			return IN_ZERO_PAGE(mode) ? MEM_FETCH_RAM(addr) : Mem_Fetch(addr);
 	}
 	return 0xFF;
 }
@@ -195,7 +207,7 @@ static u8 Opcode_Get_Value(u8 mode, u8 cross) {
 /* Unsupported opcodes */
 DEFINE_OP(UNS) {}
 
-INLINED void Do_Nmi(void) {
+void Do_Nmi(void) {
     Push_Stack((u8)(PC >> 8));
     Push_Stack((u8)(PC & 0x00FF));
     Push_Stack(P);
@@ -203,6 +215,18 @@ INLINED void Do_Nmi(void) {
     PC = Mem_Fetch16(0xFFFA);
 }
 
+/* Like an NMI, through the IRQ/BRK vector.  The 7 cycles the sequence
+ * takes are charged here, and B is pushed clear as for any hardware
+ * interrupt (a BRK handler may be running with it set). */
+void Do_Irq(void) {
+    Cpu_Add_Cycles(7);
+    Push_Stack((u8)(PC >> 8));
+    Push_Stack((u8)(PC & 0x00FF));
+    Push_Stack(P & ~FLG_BRK);
+    SET(FLG_INT_DIS);
+    PC = Mem_Fetch16(0xFFFE);
+}
+
 /* Alphabetized for your convenience! */
 
 /* opcode: ADC
@@ -242,11 +266,11 @@ DEFINE_OP(ASL) {
     } else {
         /* Otherwise, we do a mem fetch and a mem set */
         register u16 addr = GET_ADDRESS();
-        register u8 v = Mem_Fetch(addr);
+        register u8 v = READ_AT(addr);
         FLG((v & FLG_SIGN), FLG_CARRY);
         v <<= 1;
         FLG_NZ(v);
-        Mem_Set(addr, v);
+        WRITE_AT(addr, v);
     }
 }
 
@@ -384,10 +408,10 @@ DEFINE_OP(CPY) {
  * Flags Affected: Z, N  */ 
 DEFINE_OP(DEC) {
     register u16 addr = GET_ADDRESS();
-    register u8 v = Mem_Fetch(addr);
+    register u8 v = READ_AT(addr);
     --v;
     FLG_NZ(v);
-    Mem_Set(addr, v);
+    WRITE_AT(addr, v);
 }
 
 /* opcode: DEX
@@ -428,10 +452,10 @@ DEFINE_OP(EOR) {
  * Flags Affected: Z, N */ 
 DEFINE_OP(INC) {
     register u16 addr = GET_ADDRESS();
-    register u8 v = Mem_Fetch(addr);
+    register u8 v = READ_AT(addr);
     ++v;
     FLG_NZ(v);
-    Mem_Set(addr, v);
+    WRITE_AT(addr, v);
 }
 
 /* opcode: INX
@@ -514,11 +538,11 @@ DEFINE_OP(LSR) {
     } else {
         /* Memory is fetched, in order to manipulate it. */
         register u16 addr = GET_ADDRESS();
-        register u8 v = Mem_Fetch(addr);
+        register u8 v = READ_AT(addr);
         FLG((v & FLG_CARRY), FLG_CARRY);
         v >>= 1;
         FLG_NZ(v);
-        Mem_Set(addr, v);
+        WRITE_AT(addr, v);
     }
 }
 
@@ -582,11 +606,11 @@ DEFINE_OP(ROL) {
         FLG_NZ(A);
     } else {
         register u16 addr = GET_ADDRESS();
-        register u8 v = Mem_Fetch(addr);
+        register u8 v = READ_AT(addr);
         FLG((v & FLG_SIGN), FLG_CARRY);
         v = (v << 1) | c;
         FLG_NZ(v);
-        Mem_Set(addr, v);
+        WRITE_AT(addr, v);
     }
 }
 
@@ -605,11 +629,11 @@ DEFINE_OP(ROR) {
         FLG_NZ(A);
     } else {
         register u16 addr = GET_ADDRESS();
-        register u8 v = Mem_Fetch(addr);
+        register u8 v = READ_AT(addr);
         FLG((v & FLG_CARRY), FLG_CARRY);
         v = (v >> 1) | c;
         FLG_NZ(v);
-        Mem_Set(addr, v);
+        WRITE_AT(addr, v);
     }
 }
 
@@ -639,7 +663,7 @@ DEFINE_OP(RTS) {
  * +1 On Page Cross: AX, AY, IY
  * Flags Affected: C, Z, N, V */ 
 DEFINE_OP(SBC) {
-    register u8 v = GET_VALUE();
+    register u8 v = GET_VALUE1();
     A = Do_Add(A, ~v, (P & FLG_CARRY));
     Cpu_Dump();
 }
@@ -676,7 +700,7 @@ DEFINE_OP(SEI) {
  * Address Modes: ZP, ZX, AB, AX, AY, IX, IY */ 
 DEFINE_OP(STA) {
     register u16 addr = GET_ADDRESS();
-    Mem_Set(addr, A);
+    WRITE_AT(addr, A);
 }
 
 /* opcode: STX
@@ -684,7 +708,7 @@ DEFINE_OP(STA) {
  * Address Modes: ZP, ZY, AB */ 
 DEFINE_OP(STX) {
     register u16 addr = GET_ADDRESS();
-    Mem_Set(addr, X);
+    WRITE_AT(addr, X);
 }
 
 /* opcode: STY
@@ -694,7 +718,7 @@ DEFINE_OP(STX) {
  * Flags Affected:  */ 
 DEFINE_OP(STY) {
     register u16 addr = GET_ADDRESS();
-    Mem_Set(addr, Y);
+    WRITE_AT(addr, Y);
 }
 
 /* opcode: TAX
@@ -787,12 +811,12 @@ INLINED static void Do_Branch(u8 cond, u8 opcode) {
 
 /* Stack-related functions */
 INLINED static void Push_Stack(u8 v) {
-    Mem_Set(STACK_PAGE | S, v);
+    MEM_SET_RAM(STACK_PAGE | S, v);
     S--;
 }
 
 INLINED static u8 Pull_Stack() {
-    return Mem_Fetch(STACK_PAGE | ++S);
+    return MEM_FETCH_RAM(STACK_PAGE | ++S);
 }
 
 #undef A
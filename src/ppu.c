@@ -19,13 +19,10 @@
 #include "bitwise.h"
 #include "cart.h"
 #include "render.h"
+#include "sched.h"
 
 #define PPU_POWERUP_NTSC 29658
 
-#define MIRROR_HORIZONTAL   0
-#define MIRROR_VERTICAL     1
-#define MIRROR_FOUR_SCREEN  2
-
 /* Local function declarations */
 
 static INLINED u8 Read_Ppu_Status(void);
@@ -46,41 +43,178 @@ static void Write_Vram(u16 addr, u8 byte);
 
         extern void Log_Line(const char *format, ...);
 
-ppu_2c02 ppu;
+/* What the pattern tables read without a cartridge, and its tiles */
+static u8 chr_open_bus[PPU_PAGE_SIZE];
+static chr_tile chr_open_bus_tiles[PPU_PAGE_TILES];
+
+ppu_2c02 ppu = {
+    .page = {
+        chr_open_bus, chr_open_bus, chr_open_bus, chr_open_bus,
+        chr_open_bus, chr_open_bus, chr_open_bus, chr_open_bus
+    },
+    .tiles = {
+        chr_open_bus_tiles, chr_open_bus_tiles,
+        chr_open_bus_tiles, chr_open_bus_tiles,
+        chr_open_bus_tiles, chr_open_bus_tiles,
+        chr_open_bus_tiles, chr_open_bus_tiles
+    }
+};
+
+/* Cartridge hardware watching PPU address line A12 (see
+ * Ppu_Set_A12_Hook) */
+static void (*a12_clock)(void);
+static void (*a12_retime)(void);
+
+/* Dots at which A12 rises while rendering, after having been low long
+ * enough for a mapper to count it: the first sprite pattern fetch from
+ * $1000, or the first background one for the next line */
+#define A12_SPRITE_DOT      260
+#define A12_PREFETCH_DOT    324
 
 /* Initialize PPU */
-INLINED void Ppu_Init(void) {
+void Ppu_Init(void) {
     memset(ppu.nt, 0xFF, sizeof(u8) * 0x2000);
+    Render_Invalidate();
+    Ppu_Resync();
 }
 
-INLINED void Set_Nametable_Mirroring(u8 mode) {
+void Set_Nametable_Mirroring(u8 mode) {
+    register u8 **nt_map = ppu.page + PPU_NT_PAGE;
+    register u8 i;
+
     switch (mode) {
         case MIRROR_HORIZONTAL:
-            ppu.nt_map[0] = ppu.nt_map[1] = ppu.nt;
-            ppu.nt_map[2] = ppu.nt_map[3] = ppu.nt + 0x400;
+            nt_map[0] = nt_map[1] = ppu.nt;
+            nt_map[2] = nt_map[3] = ppu.nt + 0x400;
             break;
         case MIRROR_VERTICAL:
-            ppu.nt_map[0] = ppu.nt_map[2] = ppu.nt;
-            ppu.nt_map[1] = ppu.nt_map[3] = ppu.nt + 0x400;
+            nt_map[0] = nt_map[2] = ppu.nt;
+            nt_map[1] = nt_map[3] = ppu.nt + 0x400;
+            break;
+        case MIRROR_SINGLE_LOW:
+            nt_map[0] = nt_map[1] = ppu.nt;
+            nt_map[2] = nt_map[3] = ppu.nt;
+            break;
+        case MIRROR_SINGLE_HIGH:
+            nt_map[0] = nt_map[1] = ppu.nt + 0x400;
+            nt_map[2] = nt_map[3] = ppu.nt + 0x400;
             break;
         case MIRROR_FOUR_SCREEN: default:
-            ppu.nt_map[0] = ppu.nt;
-            ppu.nt_map[1] = ppu.nt + 0x400;
-            ppu.nt_map[2] = ppu.nt + 0x800;
-            ppu.nt_map[3] = ppu.nt + 0xC00;
+            nt_map[0] = ppu.nt;
+            nt_map[1] = ppu.nt + 0x400;
+            nt_map[2] = ppu.nt + 0x800;
+            nt_map[3] = ppu.nt + 0xC00;
             break;
     }
+    /* $3000-$3EFF mirrors $2000-$2EFF */
+    for (i = 0; i < 4; i++) nt_map[4 + i] = nt_map[i];
+}
+
+/* Func: void Ppu_Map_Chr(u8 page, u8 *data, const chr_tile *tiles)
+ * Desc: Points a 1K page of the pattern tables at CHR data and its
+ *       decoded tiles, or at open bus if data is 0. */
+void Ppu_Map_Chr(u8 page, u8 *data, const chr_tile *tiles) {
+    page &= PPU_CHR_PAGES - 1;
+    ppu.page[page] = data ? data : chr_open_bus;
+    ppu.tiles[page] = data ? tiles : chr_open_bus_tiles;
+}
+
+/* Sprites evaluated for each scanline that can show them (line 240 is
+ * only evaluated, see Tall_Sprites_A12_Dot), and the sprite height they
+ * were evaluated for, 0 once OAM has changed since */
+#define SPRITE_LINES    241
+static ppu_sprite_line sprite_lines[SPRITE_LINES];
+static const ppu_sprite_line no_sprites;
+static u8 sprites_height;
+
+/* Lists the first SPRITES_PER_LINE sprites in range of each line, in
+ * OAM order.  A sprite shows from the line after its Y. */
+static void Evaluate_Sprites(u8 height) {
+    register ppu_sprite_line *line;
+    register u32 i, y, end;
+
+    memset(sprite_lines, 0, sizeof(sprite_lines));
+    for (i = 0; i < 0x100; i += 4) {
+        y = ppu.oam[i] + 1;
+        end = (y + height < SPRITE_LINES) ? y + height : SPRITE_LINES;
+        for (line = sprite_lines + y; line < sprite_lines + end; line++) {
+            if (SPRITES_PER_LINE == line->count) {
+                line->flags |= SPRITE_LINE_OVERFLOW;
+                continue;
+            }
+            if (!i) line->flags |= SPRITE_LINE_ZERO;
+            line->oam[line->count++] = i;
+        }
+    }
+    sprites_height = height;
+}
+
+/* Func: const ppu_sprite_line *Ppu_Sprite_Line(i16 line)
+ * Desc: The sprites the given scanline shows.  OAM is only evaluated
+ *       again after it or the sprite size changed. */
+const ppu_sprite_line *Ppu_Sprite_Line(i16 line) {
+    register u8 height = (ppu.ctrl & SPRITE_SIZE) ? 16 : 8;
+
+    if (height != sprites_height) Evaluate_Sprites(height);
+    if ((u16)line >= SPRITE_LINES) return &no_sprites;
+    return &sprite_lines[line];
+}
+
+/* With 8x16 sprites each sprite picks its pattern table, so the ones
+ * the current line fetches for the next are looked up.  Unused slots
+ * fetch tile $FF, from $1000.  The pre-render line evaluates none. */
+static u32 Tall_Sprites_A12_Dot(void) {
+    register const ppu_sprite_line *next = Ppu_Sprite_Line(ppu.scanline + 1);
+    register u32 i;
+    register u8 low = 0, high = 0;
+
+    for (i = 0; i < next->count; i++) {
+        if (ppu.oam[next->oam[i] + 1] & 1) high = 1;
+        else low = 1;
+    }
+    if (next->count < SPRITES_PER_LINE) high = 1;
+    if (ppu.ctrl & BG_PTRN_TABLE) return low ? A12_PREFETCH_DOT : 0;
+    return high ? A12_SPRITE_DOT : 0;
+}
+
+/* Dot of the current scanline at which A12 rises, or 0 if it doesn't */
+static u32 A12_Rise_Dot(void) {
+    if (!(ppu.mask & (SHOW_BG | SHOW_SPRITES)) || ppu.scanline >= 240) {
+        return 0;
+    }
+    if (ppu.ctrl & SPRITE_SIZE) return Tall_Sprites_A12_Dot();
+    switch (ppu.ctrl & (BG_PTRN_TABLE | SPRITE_PTRN_TABLE)) {
+        case SPRITE_PTRN_TABLE: return A12_SPRITE_DOT;
+        case BG_PTRN_TABLE: return A12_PREFETCH_DOT;
+        default: return 0;
+    }
 }
 
-INLINED void Ppu_Add_Cycles(u32 cycles) {
-    ppu.cycles += cycles;
+/* Clocks the A12 hook if the current line's rise falls after dot from
+ * and by ppu.cycles (which may be past the end of the line) */
+static INLINED void Clock_A12(u32 from) {
+    register u32 dot;
+
+    if (!a12_clock) return;
+    dot = A12_Rise_Dot();
+    if (dot && from < dot && dot <= ppu.cycles) a12_clock();
+}
+
+/* Moves the PPU on by the given number of dots, rendering each
+ * scanline it finishes. */
+static void Step_Dots(u32 dots) {
+    register u32 from = ppu.cycles;
+
+    ppu.cycles += dots;
+    Clock_A12(from);
     /* Check for rendering code */
-    if (ppu.cycles > 340) {
+    while (ppu.cycles > 340) {
         ppu.cycles -= 340;
         
         ppu.scanline = (ppu.scanline == 260) ? -1 : ppu.scanline + 1;
         if (ppu.scanline == -1) {
 			ppu.scrollx = ppu.scrolly = 0;
+            FLAG_CLEAR(ppu.status, SPRITE0_HIT | SPRITE_OVERFLOW);
 		}
         Render_Scanline(ppu.scanline);
         if (ppu.scanline == 241) {
@@ -98,11 +232,225 @@ INLINED void Ppu_Add_Cycles(u32 cycles) {
             ppu.frame_check = 0;
             ppu.frame++;
         }
+        Clock_A12(0);
+    }
+}
+
+/* CPU cycles until the PPU gets to the start of the scanline the given
+ * number of lines on.  Scanlines are 340 dots apart (see Step_Dots). */
+static u32 Cycles_To_Line(u32 lines) {
+    u32 dots = ((ppu.cycles < 341) ? 341 - ppu.cycles : 1) + (lines - 1) * 340;
+    return (dots + 2) / 3;
+}
+
+/* CPU cycles until the scanline 240 -> 241 step, the only point at
+ * which the PPU raises NMI */
+static u32 Cycles_To_Vblank(void) {
+    return Cycles_To_Line(ppu.scanline < 241 ? 241 - ppu.scanline : 503 - ppu.scanline);
+}
+
+/* SCHED_VBLANK: runs the PPU through the step, then waits for the
+ * next one.  Frame boundaries are also when saves are written back. */
+static void Vblank(void) {
+    Ppu_Sync();
+    Mem_Sync_Prg_Ram();
+    Sched_Set(SCHED_VBLANK, ppu.synced_at + Cycles_To_Vblank(), Vblank);
+}
+
+/* Lines from the current one to the start of the given one, 1-262 */
+static u32 Lines_To(i16 line) {
+    return ((line - ppu.scanline + 261) % 262) + 1;
+}
+
+static void Sprite_Status(void);
+
+/* Schedules SCHED_SPRITE_STATUS for the start of the first scanline
+ * that may set sprite 0 hit or sprite overflow, or for the pre-render
+ * line if either is set to be cleared.  Rendering sets them a scanline
+ * at a time (see Render_Scanline), so idle loops polling PPUSTATUS run
+ * up to exactly there. */
+static void Predict_Sprite_Status(void) {
+    register const ppu_sprite_line *sprites;
+    register u32 n, limit;
+    register i16 line;
+    register u8 hit, overflow;
+
+    hit = ((SHOW_BG | SHOW_SPRITES) == (ppu.mask & (SHOW_BG | SHOW_SPRITES))) &&
+          !(ppu.status & SPRITE0_HIT);
+    overflow = (ppu.mask & (SHOW_BG | SHOW_SPRITES)) &&
+               !(ppu.status & SPRITE_OVERFLOW);
+    limit = (ppu.status & (SPRITE0_HIT | SPRITE_OVERFLOW)) ? Lines_To(-1) : 263;
+
+    line = ppu.scanline;
+    if (!hit && !overflow) n = limit;
+    else for (n = 1; n < limit; n++) {
+        line = (260 == line) ? -1 : line + 1;
+        if (line >= 240) continue;
+        sprites = Ppu_Sprite_Line(line);
+        if ((hit && (sprites->flags & SPRITE_LINE_ZERO)) ||
+            (overflow && (sprites->flags & SPRITE_LINE_OVERFLOW))) {
+            break;
+        }
+    }
+    if (n < 263) {
+        Sched_Set(SCHED_SPRITE_STATUS, ppu.synced_at + Cycles_To_Line(n), Sprite_Status);
+    } else {
+        Sched_Cancel(SCHED_SPRITE_STATUS);
+    }
+}
+
+/* SCHED_SPRITE_STATUS: runs the PPU through the line, then looks for
+ * the next one */
+static void Sprite_Status(void) {
+    Ppu_Sync();
+    Predict_Sprite_Status();
+}
+
+/* OAM was written: the sprites are evaluated again when next looked
+ * at, and the prediction is redone from the next line, rather than for
+ * each byte of a run of writes */
+static void Oam_Changed(void) {
+    sprites_height = 0;
+    Sched_Set(SCHED_SPRITE_STATUS, ppu.synced_at + Cycles_To_Line(1), Sprite_Status);
+}
+
+/* Func: void Ppu_Sync(void)
+ * Desc: Catches the PPU up with the CPU.  The scheduler only calls
+ *       this at vblank; anything else that looks at the PPU's state
+ *       calls it first. */
+void Ppu_Sync(void) {
+    register u64 now = Cpu_Get_Cycles();
+
+    Step_Dots(3 * (u32)(now - ppu.synced_at));
+    ppu.synced_at = now;
+}
+
+/* Schedules the PPU's events (and the cartridge's, which go by it)
+ * from where it has been run up to */
+static void Schedule_Events(void) {
+    Sched_Set(SCHED_VBLANK, ppu.synced_at + Cycles_To_Vblank(), Vblank);
+    Predict_Sprite_Status();
+    if (a12_retime) a12_retime();
+}
+
+/* Func: void Ppu_Resync(void)
+ * Desc: Takes the PPU to be in step with the CPU as they are now, and
+ *       schedules vblank from there.  For after either was set up
+ *       directly rather than by running. */
+void Ppu_Resync(void) {
+    ppu.synced_at = Cpu_Get_Cycles();
+    Schedule_Events();
+}
+
+/* Func: void Ppu_Restore(void)
+ * Desc: Takes up a PPU copied back into ppu whole (see Lanes_Load):
+ *       drops what was worked out from the old one's OAM and name
+ *       tables, catches it up with the CPU and schedules its events.
+ *       Whatever it raises on the way (NMI, mapper IRQ) is left to
+ *       the CPU as usual. */
+void Ppu_Restore(void) {
+    sprites_height = 0;
+    Render_Invalidate();
+    Ppu_Sync();
+    Schedule_Events();
+}
+
+/* Func: void Ppu_Set_A12_Hook(void (*clock)(void), void (*retime)(void))
+ * Desc: Hooks cartridge hardware onto PPU address line A12: clock is
+ *       called at each rise while rendering (as the PPU catches up, so
+ *       no earlier than the next Ppu_Sync), and retime whenever what
+ *       Ppu_A12_Rise_At predicts may have changed.  0 unhooks. */
+void Ppu_Set_A12_Hook(void (*clock)(void), void (*retime)(void)) {
+    a12_clock = clock;
+    a12_retime = retime;
+}
+
+/* Func: u64 Ppu_A12_Rise_At(u32 n)
+ * Desc: Cycle count by which A12 will have risen n more times if the
+ *       PPU's setup doesn't change, or SCHED_NEVER if it won't.  With
+ *       8x16 sprites this is the earliest it may happen. */
+u64 Ppu_A12_Rise_At(u32 n) {
+    register i16 line;
+    register u32 dot, dots;
+
+    Ppu_Sync();
+    if (!n || !(ppu.mask & (SHOW_BG | SHOW_SPRITES))) return SCHED_NEVER;
+    switch (ppu.ctrl & (SPRITE_SIZE | BG_PTRN_TABLE | SPRITE_PTRN_TABLE)) {
+        case BG_PTRN_TABLE: dot = A12_PREFETCH_DOT; break;
+        case SPRITE_PTRN_TABLE: dot = A12_SPRITE_DOT; break;
+        default:
+            if (!(ppu.ctrl & SPRITE_SIZE)) return SCHED_NEVER;
+            dot = A12_SPRITE_DOT;
+            break;
+    }
+
+    /* The rest of this line, then whole ones */
+    line = ppu.scanline;
+    if (line < 240 && ppu.cycles < dot && !--n) {
+        return ppu.synced_at + (dot - ppu.cycles + 2) / 3;
+    }
+    dots = 340 - ppu.cycles;
+    for (;;) {
+        line = (260 == line) ? -1 : line + 1;
+        if (line < 240 && !--n) return ppu.synced_at + (dots + dot + 2) / 3;
+        dots += 340;
+    }
+}
+
+/* Func: u32 Ppu_Cycles_To_Vram_Access(void)
+ * Desc: CPU cycles until rendering next reads VRAM or moves v_addr:
+ *       every scanline with the background on, otherwise only the
+ *       pre-render line.  PPUDATA writes made within fewer cycles than
+ *       this can all be made at once. */
+u32 Ppu_Cycles_To_Vram_Access(void) {
+    Ppu_Sync();
+    return Cycles_To_Line((ppu.mask & SHOW_BG) ? 1 : 261 - ppu.scanline);
+}
+
+/* Func: void Ppu_Write_Data_Block(const u8 *data, u32 count)
+ * Desc: Same as count writes to PPUDATA.  Runs of bytes that land in
+ *       one nametable are copied in one go. */
+void Ppu_Write_Data_Block(const u8 *data, u32 count) {
+    register u16 addr, offset;
+    register u32 n;
+
+    if (!count) return;
+    Ppu_Sync();
+    ppu.last_write = data[count - 1];
+    while (count) {
+        addr = ppu.v_addr & 0x3FFF;
+        if ((ppu.ctrl & VRAM_INCREMENT) || addr < 0x2000 || addr >= 0x3F00) {
+            Write_Ppu_Data(*data++);
+            count--;
+            continue;
+        }
+        offset = addr & 0x3FF;
+        n = 0x400 - offset;
+        if (addr + n > 0x3F00) n = 0x3F00 - addr;
+        if (n > count) n = count;
+        memcpy(ppu.page[addr >> 10] + offset, data, n);
+        Render_Vram_Written(addr, n);
+        ppu.v_addr += n;
+        data += n;
+        count -= n;
     }
 }
 
+/* Func: void Ppu_Oam_Dma(const u8 *data)
+ * Desc: Same as 256 writes to OAMDATA: the page of data is copied into
+ *       OAM from OAMADDR on, wrapping round to leave OAMADDR as it was. */
+void Ppu_Oam_Dma(const u8 *data) {
+    register u32 n = 0x100 - ppu.oamaddr;
+
+    Ppu_Sync();
+    memcpy(ppu.oam + ppu.oamaddr, data, n);
+    memcpy(ppu.oam, data + n, ppu.oamaddr);
+    Oam_Changed();
+}
+
 /* Read/Write */
 u8 Read_Ppu(u16 addr) {
+    Ppu_Sync();
     switch (addr) {
         case PPUSTATUS: return Read_Ppu_Status();
         case OAMDATA: return Read_Oam_Data();
@@ -114,14 +462,19 @@ u8 Read_Ppu(u16 addr) {
 }
 
 void Write_Ppu(u16 addr, u8 value) {
+    Ppu_Sync();
     ppu.last_write = value;
     //Log_Line("Writing to PPU address %04x, value %02x", addr, value);
     switch (addr) {
         case PPUCTRL:
             if (Cpu_Get_Cycles() > PPU_POWERUP_NTSC) Write_Ppu_Ctrl(value); 
+            Predict_Sprite_Status();
+            if (a12_retime) a12_retime();
         break;
         case PPUMASK: 
             if (Cpu_Get_Cycles() > PPU_POWERUP_NTSC) Write_Ppu_Mask(value);
+            Predict_Sprite_Status();
+            if (a12_retime) a12_retime();
         break;
         case OAMADDR: Write_Ppu_Oam_Addr(value); break;
         case OAMDATA: Write_Ppu_Oam_Data(value); break;
@@ -146,7 +499,7 @@ static INLINED u8 Read_Ppu_Status(void) {
     status |= ppu.last_write & LSB_OF_PPU;
     FLAG_CLEAR(ppu.status, VBLANK_STARTED);
     ppu.latch = 0;
-    return status | SPRITE0_HIT;
+    return status;
 }
 
 /* Read OAMDATA */
@@ -184,6 +537,7 @@ static INLINED void Write_Ppu_Oam_Addr(u8 value) {
 /* Set the OAMDATA */
 static INLINED void Write_Ppu_Oam_Data(u8 value) {
     ppu.oam[ppu.oamaddr++] = value;
+    Oam_Changed();
 }
 
 /* Set PPUSCROLL
@@ -227,14 +581,11 @@ INLINED void Write_Ppu_Data(u8 value) {
 static u8 Read_Vram(u16 addr) {
     register u8 value = 0;
     addr &= 0x3FFF;
-    if (addr < 0x2000) return Read_Cartridge_Chr(addr);
+    if (addr < 0x2000) return Ppu_Peek(addr);
     else if (addr < 0x3F00) {
-        /* Resolve address using nametable mirror map and offset. */
-        register u8 index = (addr >> 10) & 0x03;
-        register u16 offset = addr & 0x3FF;
         /* We technically lag by one fetch. */
         value = ppu.vram_value;
-        ppu.vram_value = ppu.nt_map[index][offset];
+        ppu.vram_value = Ppu_Peek(addr);
         return value;
     } else {
         /* Palette data */
@@ -248,15 +599,11 @@ static u8 Read_Vram(u16 addr) {
 static void Write_Vram(u16 addr, u8 value) {
     addr &= 0x3FFF;
     if (addr < 0x2000) {
-#if 0
-        Log_Line("Invalid write address %04X: %02X", addr, value);/* Write_Cartridge_Chr(addr, value) */
-#endif
-    }
-    else if (addr < 0x3F00) {
-        /* Resolve address using nametable mirror map and offset. */
-        register u8 index = (addr >> 10) & 0x03;
-        register u16 offset = addr & 0x3FF;
-        ppu.nt_map[index][offset] = value;
+        Write_Cartridge_Chr(addr, value);
+        Render_Vram_Written(addr, 1);
+    } else if (addr < 0x3F00) {
+        ppu.page[addr >> 10][addr & (PPU_PAGE_SIZE - 1)] = value;
+        Render_Vram_Written(addr, 1);
     } else {
         /* Palette data */
         if (4 == (addr & 0x7) || 0 == (addr & 0xF))
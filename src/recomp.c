@@ -0,0 +1,492 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: recomp.c
+ *
+ * Description:
+ *
+ *      Ahead-of-time recompiler.  Loads a cartridge, follows the code
+ *      in PRG ROM from the interrupt vectors (and any extra entry
+ *      points given) by recursive descent, and writes a C file with one
+ *      function per reachable block, for Cpu_Load_Aot.
+ *
+ *          recomp <rom> <out.c> [entry ...]
+ *
+ *      Blocks are split exactly the way the threaded core decodes them
+ *      (see Decode_Block in cpu-threaded.c), since a translated block
+ *      is only ever used in place of the decoded block with the same
+ *      start and bytes.  Code that is only reached through indirect
+ *      jumps, RTS/RTI tricks or other PRG banks isn't found; the core
+ *      interprets it as before.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "types.h"
+#include "cart.h"
+#include "chr-tiles.h"
+#include "opcode.h"
+#include "cpu.h"
+#include "cpu-block.h"
+#include "cpu-aot.h"
+
+#define ROM_BASE    0x8000
+#define ROM_SIZE    0x8000
+
+/* Shorter blocks run faster in the threaded core than through a call
+ * (and the register syncing around it), so they aren't translated */
+#define MIN_BLOCK_OPS 4
+
+/* Instructions, in the order OPCODE_LIST names them */
+enum {
+    I_ADC, I_AND, I_ASL, I_BCC, I_BCS, I_BEQ, I_BIT, I_BMI, I_BNE, I_BPL,
+    I_BRK, I_BVC, I_BVS, I_CLC, I_CLD, I_CLI, I_CLV, I_CMP, I_CPX, I_CPY,
+    I_DEC, I_DEX, I_DEY, I_EOR, I_INC, I_INX, I_INY, I_JMP, I_JSR, I_LDA,
+    I_LDX, I_LDY, I_LSR, I_NOP, I_ORA, I_PHA, I_PHP, I_PLA, I_PLP, I_ROL,
+    I_ROR, I_RTI, I_RTS, I_SBC, I_SEC, I_SED, I_SEI, I_STA, I_STX, I_STY,
+    I_TAX, I_TAY, I_TSX, I_TXA, I_TXS, I_TYA, I_UNS
+};
+
+#define OP(code, name, mode, cycles) I_##name,
+static const u8 op_insn[] = {
+    OPCODE_LIST(OP)
+};
+#undef OP
+
+#define OP(code, name, mode, cycles) cycles,
+static const u8 op_cycles[] = {
+    OPCODE_LIST(OP)
+};
+#undef OP
+
+#define OP(code, name, mode, cycles) mode,
+static const u8 op_modes[] = {
+    OPCODE_LIST(OP)
+};
+#undef OP
+
+#define OP(code, name, mode, cycles) #name,
+static const char *op_names[] = {
+    OPCODE_LIST(OP)
+};
+#undef OP
+
+#define mode(name, length) length,
+static const u8 mode_lengths[] = {
+    ADDRESS_MODES(mode)
+};
+#undef mode
+
+/* A block as the threaded core would decode it */
+typedef struct rc_block {
+    u16 pc;
+    u8 count;
+    u8 bytes;
+    u32 hash;
+    u16 op_pc[BLOCK_MAX_OPS];
+} rc_block;
+
+static u8 seen[ROM_SIZE];
+static u16 work[ROM_SIZE];
+static u32 work_count;
+
+static rc_block *blocks;
+static u32 block_count;
+
+static FILE *out;
+
+/* Called by Load_iNES; recomp has no PPU or CPU memory map */
+void Set_Nametable_Mirroring(u8 mode) {
+}
+
+void Mem_Map_Prg(u16 address, u16 length, const u8 *data) {
+}
+
+void Mem_Map_Prg_Ram(u8 *data) {
+}
+
+void Ppu_Map_Chr(u8 page, u8 *data, const chr_tile *tiles) {
+}
+
+/* Called by the MMC3 IRQ counter, which never runs here */
+void Ppu_Set_A12_Hook(void (*clock)(void), void (*retime)(void)) {
+}
+
+u64 Ppu_A12_Rise_At(u32 n) {
+    return SCHED_NEVER;
+}
+
+void Ppu_Sync(void) {
+}
+
+void Cpu_Irq(u8 source) {
+}
+
+void Cpu_Ack_Irq(u8 source) {
+}
+
+static u16 Operand(u16 pc) {
+    register u8 length = mode_lengths[op_modes[Read_Cartridge_Prg(pc)]];
+    if (length < 2) return 0;
+    if (length < 3) return Read_Cartridge_Prg(pc + 1);
+    return Read_Cartridge_Prg(pc + 1) | (Read_Cartridge_Prg(pc + 2) << 8);
+}
+
+/* Same as Ends_Block in cpu-threaded.c */
+static u8 Ends_Block(u8 opcode) {
+    switch (op_insn[opcode]) {
+        case I_BRK: case I_JSR: case I_RTI: case I_JMP: case I_RTS:
+        case I_CLI: case I_PLP:
+            return 1;
+        default:
+            return (RE == op_modes[opcode]) || !op_cycles[opcode];
+    }
+}
+
+static u16 Vector(u16 address) {
+    return Read_Cartridge_Prg(address) | (Read_Cartridge_Prg(address + 1) << 8);
+}
+
+static void Add_Entry(u32 pc) {
+    if (pc < ROM_BASE || pc > 0xFFFF || seen[pc - ROM_BASE]) return;
+    seen[pc - ROM_BASE] = 1;
+    work[work_count++] = pc;
+}
+
+/* Decode the block at pc and queue every block it may go on to */
+static void Walk_Block(u16 start) {
+    rc_block *blk = &blocks[block_count];
+    register u32 pc = start;
+    register u8 opcode, length;
+
+    blk->pc = start;
+    blk->count = blk->bytes = 0;
+    do {
+        opcode = Read_Cartridge_Prg(pc);
+        length = mode_lengths[op_modes[opcode]];
+        if (pc + length > 0x10000) break;
+        blk->op_pc[blk->count++] = pc;
+        blk->bytes += length;
+        pc += length;
+    } while (!Ends_Block(opcode) && blk->count < BLOCK_MAX_OPS);
+
+    if (!blk->count) return;
+    blk->hash = AOT_HASH_INIT;
+    for (pc = start; pc < (u32)start + blk->bytes; pc++) {
+        blk->hash = AOT_HASH_STEP(blk->hash, Read_Cartridge_Prg(pc));
+    }
+    block_count++;
+
+    if (!Ends_Block(opcode)) {
+        Add_Entry(pc);
+        return;
+    }
+    switch (op_insn[opcode]) {
+        case I_JSR:
+            Add_Entry(Operand(pc - 3));
+            Add_Entry(pc);
+            break;
+        case I_CLI: case I_PLP:
+            Add_Entry(pc);
+            break;
+        case I_JMP:
+            if (AB == op_modes[opcode]) Add_Entry(Operand(pc - 3));
+            break;
+        default:
+            if (RE == op_modes[opcode]) {
+                Add_Entry((u16)(pc + (i8)Operand(pc - 2)));
+                Add_Entry(pc);
+            }
+            break;
+    }
+}
+
+/* Emitters.  Generated code is written in terms of the macros in
+ * cpu-aot.h; the C compiler folds the RAM/I/O checks on constant
+ * addresses. */
+#define emit(...) fprintf(out, __VA_ARGS__)
+
+static const char *Index_Reg(u8 mode) {
+    return (ZY == mode || AY == mode || IY == mode) ? "y" : "x";
+}
+
+/* Sets ad to the effective address of a memory operand (or returns the
+ * constant one in *fixed) */
+static u8 Emit_Address(u8 mode, u16 operand, u16 *fixed) {
+    switch (mode) {
+        case ZP: case AB:
+            *fixed = operand;
+            return 1;
+        case ZX: case ZY:
+            emit("    ad = (u8)(0x%02X + %s);\n", operand, Index_Reg(mode));
+            return 0;
+        case AX: case AY:
+            emit("    ad = 0x%04X + %s;\n", operand, Index_Reg(mode));
+            return 0;
+        case IX:
+            emit("    t = 0x%02X + x;\n", operand);
+            emit("    ad = RAM_RD(t) | (RAM_RD((u8)(t + 1)) << 8);\n");
+            return 0;
+        case IY:
+            emit("    ad = RAM_RD(0x%02X) | (RAM_RD(0x%02X) << 8);\n",
+                 operand, (u8)(operand + 1));
+            return 0;
+    }
+    return 0;
+}
+
+/* v = operand.  Loads (but not read-modify-writes) add the page
+ * crossing penalty, after the access like the interpreter. */
+static void Emit_Load(u8 mode, u16 operand, u8 penalty) {
+    u16 fixed;
+    char where[16];
+
+    if (IM == mode) {
+        emit("    v = 0x%02X;\n", operand);
+        return;
+    }
+    if (IY == mode) {
+        Emit_Address(mode, operand, &fixed);
+        if (penalty) emit("    t = ((ad & 0xFF) + y) > 0xFF;\n");
+        emit("    ad += y;\n");
+        emit("    v = ANY_RD(ad);\n");
+        if (penalty) emit("    cyc += t;\n");
+        return;
+    }
+    if (Emit_Address(mode, operand, &fixed)) {
+        sprintf(where, "0x%04X", fixed);
+    } else {
+        strcpy(where, "ad");
+    }
+    if (ZP == mode || ZX == mode || ZY == mode) {
+        emit("    v = RAM_RD(%s);\n", where);
+    } else {
+        emit("    v = ANY_RD(%s);\n", where);
+    }
+    if (penalty && (AX == mode || AY == mode)) {
+        emit("    cyc += CROSS(0x%04X, ad);\n", operand);
+    }
+}
+
+/* Writes value to the operand; leaves at next if that needs the core */
+static void Emit_Store(u8 mode, u16 operand, const char *value, u16 next,
+                       u8 cycles) {
+    u16 fixed;
+    char where[16];
+
+    if (Emit_Address(mode, operand, &fixed)) {
+        sprintf(where, "0x%04X", fixed);
+    } else {
+        strcpy(where, "ad");
+    }
+    if (IY == mode) emit("    ad += y;\n");
+    if (ZP == mode || ZX == mode || ZY == mode) {
+        emit("    RAM_WR(%s, %s, 0x%04X, %u);\n", where, value, next, cycles);
+    } else {
+        emit("    ANY_WR(%s, %s, 0x%04X, %u);\n", where, value, next, cycles);
+    }
+}
+
+static void Emit_Branch(const char *cond, u16 next, u16 operand, u8 cycles) {
+    u16 target = next + (i8)operand;
+    emit("    cyc += %u;\n", cycles);
+    emit("    if (%s) { cyc += %u; AOT_LEAVE(0x%04X); }\n", cond,
+         ((next & 0xFF00) == (target & 0xFF00)) ? 1 : 2, target);
+    emit("    AOT_LEAVE(0x%04X);\n", next);
+}
+
+/* Read-modify-write; the operation works on v */
+static void Emit_Rmw(u8 mode, u16 operand, const char *op, u16 next,
+                     u8 cycles) {
+    if (AC == mode) {
+        emit("    v = a; %s a = v;\n", op);
+        return;
+    }
+    Emit_Load(mode, operand, 0);
+    emit("    %s\n", op);
+    Emit_Store(mode, operand, "v", next, cycles);
+}
+
+/* Emits one instruction.  Returns 0 if the block ends with it. */
+static u8 Emit_Op(u16 pc) {
+    u8 opcode = Read_Cartridge_Prg(pc);
+    u8 mode = op_modes[opcode];
+    u8 n = op_cycles[opcode];
+    u16 operand = Operand(pc);
+    u16 next = pc + mode_lengths[mode];
+
+    emit("    /* %04X: %s */\n", pc, op_names[opcode]);
+    switch (op_insn[opcode]) {
+        case I_ADC: Emit_Load(mode, operand, 1); emit("    ADD(v);\n"); break;
+        case I_SBC:
+            Emit_Load(mode, operand, 1);
+            emit("    v = ~v; ADD(v);\n");
+            break;
+        case I_AND: Emit_Load(mode, operand, 1); emit("    a &= v; NZ(a);\n"); break;
+        case I_ORA: Emit_Load(mode, operand, 1); emit("    a |= v; NZ(a);\n"); break;
+        case I_EOR: Emit_Load(mode, operand, 1); emit("    a ^= v; NZ(a);\n"); break;
+        case I_LDA: Emit_Load(mode, operand, 1); emit("    a = v; NZ(a);\n"); break;
+        case I_LDX: Emit_Load(mode, operand, 1); emit("    x = v; NZ(x);\n"); break;
+        case I_LDY: Emit_Load(mode, operand, 1); emit("    y = v; NZ(y);\n"); break;
+        case I_CMP: Emit_Load(mode, operand, 1); emit("    COMPARE(a, v);\n"); break;
+        case I_CPX: Emit_Load(mode, operand, 1); emit("    COMPARE(x, v);\n"); break;
+        case I_CPY: Emit_Load(mode, operand, 1); emit("    COMPARE(y, v);\n"); break;
+        case I_BIT: Emit_Load(mode, operand, 1); emit("    BIT(v);\n"); break;
+
+        case I_STA: Emit_Store(mode, operand, "a", next, n); break;
+        case I_STX: Emit_Store(mode, operand, "x", next, n); break;
+        case I_STY: Emit_Store(mode, operand, "y", next, n); break;
+
+        case I_ASL:
+            Emit_Rmw(mode, operand, "SET_C(v & 0x80); v <<= 1; NZ(v);", next, n);
+            break;
+        case I_LSR:
+            Emit_Rmw(mode, operand, "SET_C(v & 0x01); v >>= 1; NZ(v);", next, n);
+            break;
+        case I_ROL:
+            Emit_Rmw(mode, operand, "t = p & FLG_CARRY; SET_C(v & 0x80); "
+                     "v = (v << 1) | t; NZ(v);", next, n);
+            break;
+        case I_ROR:
+            Emit_Rmw(mode, operand, "t = (p & FLG_CARRY) << 7; SET_C(v & 0x01); "
+                     "v = (v >> 1) | t; NZ(v);", next, n);
+            break;
+        case I_INC: Emit_Rmw(mode, operand, "++v; NZ(v);", next, n); break;
+        case I_DEC: Emit_Rmw(mode, operand, "--v; NZ(v);", next, n); break;
+
+        case I_INX: emit("    ++x; NZ(x);\n"); break;
+        case I_INY: emit("    ++y; NZ(y);\n"); break;
+        case I_DEX: emit("    --x; NZ(x);\n"); break;
+        case I_DEY: emit("    --y; NZ(y);\n"); break;
+        case I_TAX: emit("    x = a; NZ(x);\n"); break;
+        case I_TAY: emit("    y = a; NZ(y);\n"); break;
+        case I_TSX: emit("    x = s; NZ(x);\n"); break;
+        case I_TXA: emit("    a = x; NZ(a);\n"); break;
+        case I_TYA: emit("    a = y; NZ(a);\n"); break;
+        case I_TXS: emit("    s = x;\n"); break;
+
+        case I_CLC: emit("    p &= ~FLG_CARRY;\n"); break;
+        case I_SEC: emit("    p |= FLG_CARRY;\n"); break;
+        case I_CLD: emit("    p &= ~FLG_DECIMAL;\n"); break;
+        case I_SED: emit("    p |= FLG_DECIMAL;\n"); break;
+        case I_CLI: emit("    p &= ~FLG_INT_DIS;\n"); break;
+        case I_SEI: emit("    p |= FLG_INT_DIS;\n"); break;
+        case I_CLV: emit("    p &= ~FLG_OVERFLOW;\n"); break;
+        case I_NOP: break;
+
+        case I_PHA: emit("    PUSH(a, 0x%04X, %u);\n", next, n); break;
+        case I_PHP: emit("    PUSH(p | FLG_BRK, 0x%04X, %u);\n", next, n); break;
+        case I_PLA: emit("    a = PULL(); NZ(a);\n"); break;
+        case I_PLP: emit("    p = (PULL() & ~FLG_BRK) | FLG_NOT_USED;\n"); break;
+
+        case I_BCC: Emit_Branch("!(p & FLG_CARRY)", next, operand, n); return 0;
+        case I_BCS: Emit_Branch("p & FLG_CARRY", next, operand, n); return 0;
+        case I_BNE: Emit_Branch("!(p & FLG_ZERO)", next, operand, n); return 0;
+        case I_BEQ: Emit_Branch("p & FLG_ZERO", next, operand, n); return 0;
+        case I_BPL: Emit_Branch("!(p & FLG_SIGN)", next, operand, n); return 0;
+        case I_BMI: Emit_Branch("p & FLG_SIGN", next, operand, n); return 0;
+        case I_BVC: Emit_Branch("!(p & FLG_OVERFLOW)", next, operand, n); return 0;
+        case I_BVS: Emit_Branch("p & FLG_OVERFLOW", next, operand, n); return 0;
+
+        case I_JMP:
+            if (IN == mode) {
+                emit("    v = ANY_RD(0x%04X);\n", operand);
+                emit("    t = ANY_RD(0x%04X);\n",
+                     (operand & 0xFF00) | (u8)(operand + 1));
+                emit("    cyc += %u;\n", n);
+                emit("    AOT_LEAVE(v | (t << 8));\n");
+            } else {
+                emit("    cyc += %u;\n", n);
+                emit("    AOT_LEAVE(0x%04X);\n", operand);
+            }
+            return 0;
+        case I_JSR:
+            /* Both bytes get pushed before the block is left anyway */
+            emit("    STACK_WR(0x%02X);\n", (u16)(next - 1) >> 8);
+            emit("    STACK_WR(0x%02X);\n", (u8)(next - 1));
+            emit("    cyc += %u;\n", n);
+            emit("    AOT_LEAVE(0x%04X);\n", operand);
+            return 0;
+        case I_RTS:
+            emit("    ad = PULL(); ad |= PULL() << 8;\n");
+            emit("    cyc += %u;\n", n);
+            emit("    AOT_LEAVE((u16)(ad + 1));\n");
+            return 0;
+
+        default:
+            /* BRK, RTI and unsupported opcodes are left to the core */
+            emit("    AOT_LEAVE(0x%04X);\n", pc);
+            return 0;
+    }
+    emit("    cyc += %u;\n", n);
+    return 1;
+}
+
+static void Emit_Block(const rc_block *blk) {
+    register u8 i;
+
+    emit("static u32 B_%04X(void) {\n", blk->pc);
+    emit("    AOT_ENTER();\n");
+    for (i = 0; i < blk->count; i++) {
+        if (!Emit_Op(blk->op_pc[i])) break;
+    }
+    if (i == blk->count) {
+        emit("    AOT_LEAVE(0x%04X);\n", (u16)(blk->pc + blk->bytes));
+    }
+    emit("}\n\n");
+}
+
+int main(int argc, char **argv) {
+    register u32 i, emitted = 0;
+    char *end;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <rom> <out.c> [entry ...]\n", argv[0]);
+        return 1;
+    }
+    Load_Cartridge(argv[1]);
+
+    Add_Entry(Vector(0xFFFA));
+    Add_Entry(Vector(0xFFFC));
+    Add_Entry(Vector(0xFFFE));
+    for (i = 3; i < (u32)argc; i++) {
+        Add_Entry(strtoul(argv[i], &end, 16));
+    }
+
+    blocks = (rc_block *)malloc(ROM_SIZE * sizeof(rc_block));
+    while (work_count) Walk_Block(work[--work_count]);
+
+    out = fopen(argv[2], "w");
+    if (!out) {
+        fprintf(stderr, "Can't open %s\n", argv[2]);
+        return 1;
+    }
+    emit("/* Generated by recomp from %s; do not edit.\n", argv[1]);
+    emit(" * Build: gcc -O2 -shared -fPIC -Iinclude %s -o <module>.so */\n\n",
+         argv[2]);
+    emit("#define AOT_MODULE\n#include \"cpu-aot.h\"\n\n");
+    for (i = 0; i < block_count; i++) {
+        if (blocks[i].count >= MIN_BLOCK_OPS) Emit_Block(&blocks[i]);
+    }
+
+    emit("static const aot_block blocks[] = {\n");
+    for (i = 0; i < block_count; i++) {
+        if (blocks[i].count < MIN_BLOCK_OPS) continue;
+        emitted++;
+        emit("    { 0x%04X, %u, 0x%08Xu, B_%04X },\n", blocks[i].pc,
+             blocks[i].bytes, blocks[i].hash, blocks[i].pc);
+    }
+    emit("};\n\n");
+    emit("const aot_module %s = {\n", AOT_SYMBOL);
+    emit("    AOT_VERSION, Aot_Bind, %u, blocks\n};\n", emitted);
+    fclose(out);
+
+    printf("%u of %u blocks translated\n", emitted, block_count);
+    return 0;
+}
@@ -14,10 +14,12 @@
  */
 
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* #ifdef __SSE2__ */
 #include "bitwise.h"
 #include "render.h"
 #include "ppu.h"
-#include "cart.h"
 
 /* From ppu.h */
 extern ppu_2c02 ppu;
@@ -37,17 +39,19 @@ static const u32 nes_palette[] = {
 
 static u32 render_data[NES_RES_X * NES_RES_Y] = {255};
 
-INLINED u32 *Get_Render_Buffer(void) {
+u32 *Get_Render_Buffer(void) {
     return render_data;
 }
 
-INLINED u32 Sample_Nes_Palette(u8 index) {
+u32 Sample_Nes_Palette(u8 index) {
     return nes_palette[index];
 }
 
 /* Local declarations */
-static void Render_Background(u16 *background);
-static void Composite_Scanline(i16 scanline, u16 *background, u16 *spr_back, u16 *spr_front);
+static void Render_Background(u16 *background, i16 scanline);
+static void Render_Sprites(i16 scanline, const ppu_sprite_line *sprites,
+                           const u16 *background, u16 *spr_front, u16 *spr_back);
+static void Composite_Scanline(i16 scanline, u16 *background, u16 *spr_front, u16 *spr_back);
 
 
 /* Rendering Function Definitions */
@@ -59,12 +63,23 @@ void Render_Scanline(i16 scanline) {
     u16 *background = render_buffer,
         *spr_back = render_buffer + 256,
         *spr_front  = render_buffer + (2 * 256);
+    const ppu_sprite_line *sprites;
         
     /* Enforce cleared memory */
-    bzero(render_buffer, 256 * 4);
+    bzero(render_buffer, sizeof(render_buffer));
     
-    if (ppu.mask & SHOW_BG) Render_Background(background);
-    //if (ppu.mask & SHOW_SPRITES) Render_Sprites(scanline, spr_front, spr_back);
+    if (ppu.mask & SHOW_BG) Render_Background(background, scanline);
+
+    /* Sprite overflow is flagged whenever rendering is on */
+    if (scanline > 0 && scanline < 240 && (ppu.mask & (SHOW_BG | SHOW_SPRITES))) {
+        sprites = Ppu_Sprite_Line(scanline);
+        if (sprites->flags & SPRITE_LINE_OVERFLOW) {
+            FLAG_SET(ppu.status, SPRITE_OVERFLOW);
+        }
+        if (sprites->count && (ppu.mask & SHOW_SPRITES)) {
+            Render_Sprites(scanline, sprites, background, spr_front, spr_back);
+        }
+    }
     
     /* Compositor renders directly into the screen buffer. */
     if (scanline > -1 && scanline < 240) {
@@ -75,18 +90,286 @@ void Render_Scanline(i16 scanline) {
     }
 }
 
-/* Render_Background renders the background at the particular scanline.
- * Since this is rather confusing, I'm using more verbose variable names
- * and commenting the shit out of this code. */
-static void Render_Background(u16 *background) {
-    u16 clip_amount;    /* Clip offset */
-    u16 i;              /* Iterator variable */
-    u16 tile_no;        /* Tile number, as specified in name table. */
-    u16 pattern_base;   /* Base pattern table */
-    u16 pattern_offset; /* Pattern table offset */
-    u8 nt_index,        /* Name table index */
-       current_pixel,   /* Current Pixel value */
-       current_attr;    /* Attribute table value */
+/* Tiles fetched for a scanline: the 256 pixels start fine X pixels into
+ * the first one, so they span up to 33 tiles */
+#define BG_TILES    33
+
+/* Expands a decoded tile row into 8 background entries: high (the
+ * palette bits) or'd in where the pixel is opaque, 0 where it isn't. */
+static INLINED void Expand_Tile_Row(u16 *out, const u8 *row, u16 high) {
+#ifdef __SSE2__
+    register __m128i pixels, clear;
+
+    pixels = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)row),
+                               _mm_setzero_si128());
+    clear = _mm_cmpeq_epi16(pixels, _mm_setzero_si128());
+    _mm_storeu_si128((__m128i *)out,
+                     _mm_andnot_si128(clear, _mm_or_si128(pixels,
+                                                          _mm_set1_epi16(high))));
+#else
+    register u8 x;
+    for (x = 0; x < 8; x++) out[x] = row[x] ? (row[x] | high) : 0;
+#endif /* #ifdef __SSE2__ */
+}
+
+/* Bit x set for each opaque pixel x of a decoded tile row */
+static INLINED u8 Opaque_Mask(const u8 *row) {
+#ifdef __SSE2__
+    return ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadl_epi64((const __m128i *)row),
+                                             _mm_setzero_si128()));
+#else
+    register u8 x, mask = 0;
+    for (x = 0; x < 8; x++) if (row[x]) mask |= 1 << x;
+    return mask;
+#endif /* #ifdef __SSE2__ */
+}
+
+/* Render_Tiles renders a background line from the name tables a tile at
+ * a time: the name table, attribute and pattern data only change every
+ * 8 pixels, so they are fetched once per tile and the tile's row is
+ * expanded in one go.  Fine X scroll then only offsets where the
+ * scanline starts in the fetched tiles. */
+static void Render_Tiles(u16 *background, u16 pattern_base, u16 clip_amount) {
+    u16 line[BG_TILES * 8];     /* Fetched tiles, 8 pixels each */
+    u16 i, last;
+    const u8 *nt;               /* Name table, through the PPU page table */
+    const chr_tile *tile;       /* The tile's pattern, decoded */
+    u8 current_attr;            /* Attribute table value */
+
+    /* The PPU address moves on 33 tiles a line (the 32 on screen and
+     * the first of the next line's prefetch), whatever fine X is; only
+     * those the 256 pixels reach are drawn. */
+    last = (ppu.scrollx + 255) >> 3;
+    for (i = 0; i < BG_TILES; i++) {
+        if (i <= last) {
+            /* Bits 10 and 11 of the address select the name table (see
+             * PPU_PAGES); its page accounts for mirroring.  The low 10
+             * bits are the tile's offset in it. */
+            nt = ppu.page[PPU_NT_PAGE + ((ppu.v_addr >> 10) & 0x0003)];
+            tile = Ppu_Tile(pattern_base + (nt[ppu.v_addr & 0x03FF] << 4));
+
+            /* Attribute table entries cover 32x32 pixels, 8 to a row,
+             * from 0x03C0 into the name table: the top 3 bits of coarse
+             * Y pick the row, the top 3 of coarse X the entry.  Bit 1
+             * of coarse X and Y then pick the 16x16 quadrant's 2 bits. */
+                                                /* Y component */            /* X component */
+            current_attr = nt[0x03C0 + ((ppu.v_addr & 0x0380) >> 4) + ((ppu.v_addr & 0x001F) >> 2)];
+            current_attr >>= ((ppu.v_addr & 0x0040) >> 4) | (ppu.v_addr & 0x0002);
+            current_attr &= 0x03;
+
+            Expand_Tile_Row(line + i * 8, tile->pixel[ppu.scrolly],
+                            0x3F00 | (current_attr << 2));
+        }
+
+        /* Every 32 tiles we change name tables: when all x bits of the
+         * address are set (0b11111), bit 10 is flipped and they wrap
+         * to 0. */
+        if ((ppu.v_addr & 0x001F) == 0x001F) {
+            ppu.v_addr &= ~0x001F;
+            ppu.v_addr ^= 0x0400;
+        } else {
+            ppu.v_addr++;
+        }
+    }
+
+    /* Fine X is where the scanline starts in the first tile */
+    memcpy(background + clip_amount, line + ppu.scrollx + clip_amount,
+           (256 - clip_amount) * sizeof(u16));
+}
+
+/* Background plane: the four name tables, as seen through the page
+ * table, pre-rendered into one 512x480 image (2x2 screens) of background
+ * entries.  An 8x8 cell is only rendered again once a write to its name
+ * table entry, its attribute or its pattern marks it dirty, and then
+ * only when a scanline needs it, so a scanline is usually just a
+ * scrolled copy out of the plane. */
+#define PLANE_W         512
+#define PLANE_H         480
+#define PLANE_CELL_ROWS (PLANE_H / 8)
+#define PLANE_CELL_COLS (PLANE_W / 8)
+
+/* Frames drawn without the plane after a mid-frame change to the name
+ * table mapping or the background patterns, as it likely happens every
+ * frame (CHR bank or pattern table splits) */
+#define PLANE_RASTER_FRAMES 2
+
+static u16 bg_plane[PLANE_H][PLANE_W];
+static u64 bg_plane_dirty[PLANE_CELL_ROWS];    /* Bit n: cell column n */
+static u64 bg_plane_stale[256 / 64];            /* Bit n: tile n rewritten */
+static u8 bg_plane_stale_any;
+
+/* What the plane was rendered from: the name table pages, and the
+ * pattern table and its decoded pages */
+static const u8 *bg_plane_nt[4];
+static const chr_tile *bg_plane_tiles[4];
+static u16 bg_plane_base = 0xFFFF;
+static u8 bg_plane_raster;
+
+/* Marks every cell of the plane dirty, and forgets the mapping it was
+ * rendered from */
+static void Invalidate_Plane(void) {
+    memset(bg_plane_dirty, 0xFF, sizeof(bg_plane_dirty));
+    memset(bg_plane_stale, 0, sizeof(bg_plane_stale));
+    bg_plane_stale_any = 0;
+}
+
+/* Func: void Render_Invalidate(void)
+ * Desc: Drops the background plane, for when the name tables were
+ *       changed other than through Render_Vram_Written. */
+void Render_Invalidate(void) {
+    Invalidate_Plane();
+    bg_plane_base = 0xFFFF;
+}
+
+/* Func: void Render_Vram_Written(u16 addr, u16 count)
+ * Desc: Marks the cells of the background plane that count bytes of
+ *       pattern or name table memory written at addr show as dirty. */
+void Render_Vram_Written(u16 addr, u16 count) {
+    register const u8 *page;
+    register u16 offset, attr;
+    register u8 q, row, rows;
+
+    for (; count; count--, addr++) {
+        addr &= 0x3FFF;
+        if (addr < 0x2000) {
+            /* Only the pattern table the plane was rendered from
+             * matters; the cells showing the tile are found later */
+            if ((addr & 0x1000) != bg_plane_base) continue;
+            offset = (addr >> 4) & 0xFF;
+            bg_plane_stale[offset >> 6] |= 1ULL << (offset & 63);
+            bg_plane_stale_any = 1;
+            continue;
+        }
+        if (addr >= 0x3F00) continue;
+
+        /* Mirroring may show the written page as more than one of the
+         * name tables */
+        page = ppu.page[addr >> 10];
+        offset = addr & (PPU_PAGE_SIZE - 1);
+        for (q = 0; q < 4; q++) {
+            if (ppu.page[PPU_NT_PAGE + q] != page) continue;
+            if (offset < 0x03C0) {
+                bg_plane_dirty[(q >> 1) * 30 + (offset >> 5)] |=
+                    1ULL << ((q & 1) * 32 + (offset & 0x1F));
+            } else {
+                /* An attribute byte covers 4x4 cells */
+                attr = offset - 0x03C0;
+                row = (attr >> 3) * 4;
+                rows = (row + 4 > 30) ? 30 - row : 4;
+                for (; rows && row < 30; rows--, row++) {
+                    bg_plane_dirty[(q >> 1) * 30 + row] |=
+                        0x0FULL << ((q & 1) * 32 + (attr & 0x07) * 4);
+                }
+            }
+        }
+    }
+}
+
+/* Renders one 8x8 cell of the plane from the name tables */
+static void Render_Plane_Cell(u16 cx, u16 cy, u16 pattern_base) {
+    register const u8 *nt;
+    register const chr_tile *tile;
+    register u16 tx = cx & 0x1F, ty = cy % 30, high;
+    register u8 attr, row;
+
+    nt = ppu.page[PPU_NT_PAGE + (cy >= 30) * 2 + (cx >= 32)];
+    tile = Ppu_Tile(pattern_base + (nt[ty * 32 + tx] << 4));
+    attr = nt[0x03C0 + (ty >> 2) * 8 + (tx >> 2)];
+    attr = (attr >> (((ty & 0x02) << 1) | (tx & 0x02))) & 0x03;
+    high = 0x3F00 | (attr << 2);
+    for (row = 0; row < 8; row++) {
+        Expand_Tile_Row(&bg_plane[cy * 8 + row][cx * 8], tile->pixel[row], high);
+    }
+}
+
+/* Brings the plane up to date with the name table mapping and the
+ * background patterns, marking cells dirty where they changed */
+static void Check_Plane(u16 pattern_base, i16 scanline) {
+    register const chr_tile *const *tiles = ppu.tiles + (pattern_base >> 10);
+    register const u8 *nt;
+    register u16 i, cell;
+    register u8 q;
+
+    if (pattern_base != bg_plane_base ||
+        memcmp(bg_plane_nt, ppu.page + PPU_NT_PAGE, sizeof(bg_plane_nt)) ||
+        memcmp(bg_plane_tiles, tiles, sizeof(bg_plane_tiles))) {
+        if (scanline > 0 && bg_plane_base != 0xFFFF) {
+            bg_plane_raster = PLANE_RASTER_FRAMES;
+        }
+        Invalidate_Plane();
+        bg_plane_base = pattern_base;
+        for (q = 0; q < 4; q++) {
+            bg_plane_nt[q] = ppu.page[PPU_NT_PAGE + q];
+            bg_plane_tiles[q] = tiles[q];
+        }
+        return;
+    }
+
+    if (!bg_plane_stale_any) return;
+    for (q = 0; q < 4; q++) {
+        nt = bg_plane_nt[q];
+        for (i = 0; i < 0x03C0; i++) {
+            if (bg_plane_stale[nt[i] >> 6] & (1ULL << (nt[i] & 63))) {
+                cell = (q & 1) * 32 + (i & 0x1F);
+                bg_plane_dirty[(q >> 1) * 30 + (i >> 5)] |= 1ULL << cell;
+            }
+        }
+    }
+    memset(bg_plane_stale, 0, sizeof(bg_plane_stale));
+    bg_plane_stale_any = 0;
+}
+
+/* Render_Plane copies a background line out of the plane, rendering
+ * the cells it crosses first if they're dirty.  It returns 0, leaving
+ * the line to Render_Tiles, for raster effects the plane can't show. */
+static u8 Render_Plane(u16 *background, u16 pattern_base, u16 clip_amount, i16 scanline) {
+    register u16 x, y, cx, cy, n, count;
+    register u64 *dirty;
+    register const u16 *row;
+
+    /* The plane gets another go once a frame starts */
+    if (scanline == 0 && bg_plane_raster) bg_plane_raster--;
+    Check_Plane(pattern_base, scanline);
+
+    /* Coarse Y 30 and 31 fetch the attribute bytes as tiles */
+    if (bg_plane_raster || ((ppu.v_addr >> 5) & 0x1F) >= 30) return 0;
+
+    x = ((ppu.v_addr & 0x0400) >> 2) | ((ppu.v_addr & 0x001F) << 3) | ppu.scrollx;
+    y = ((ppu.v_addr & 0x0800) ? 240 : 0) + ((ppu.v_addr >> 2) & 0xF8) + ppu.scrolly;
+
+    /* Render the cells the line crosses, up to 33 with fine X */
+    cy = y >> 3;
+    dirty = bg_plane_dirty + cy;
+    if (*dirty) {
+        for (cx = x >> 3, n = ((x & 7) ? 33 : 32); n; n--, cx++) {
+            cx &= PLANE_CELL_COLS - 1;
+            if (*dirty & (1ULL << cx)) {
+                Render_Plane_Cell(cx, cy, pattern_base);
+                *dirty &= ~(1ULL << cx);
+            }
+        }
+    }
+
+    /* The scrolled copy, wrapping around to the left of the plane */
+    row = bg_plane[y];
+    x = (x + clip_amount) & (PLANE_W - 1);
+    count = 256 - clip_amount;
+    n = (PLANE_W - x < count) ? PLANE_W - x : count;
+    memcpy(background + clip_amount, row + x, n * sizeof(u16));
+    memcpy(background + clip_amount + n, row, (count - n) * sizeof(u16));
+
+    /* The 33 coarse X increments, across both name tables */
+    x = (((ppu.v_addr & 0x0400) >> 5) | (ppu.v_addr & 0x001F)) + BG_TILES;
+    ppu.v_addr = (ppu.v_addr & ~0x041F) | ((x & 0x20) << 5) | (x & 0x1F);
+    return 1;
+}
+
+/* Render_Background renders the background at the particular scanline,
+ * out of the plane where it can, then steps the PPU address on to the
+ * next line as the PPU does at dots 256 and 257. */
+static void Render_Background(u16 *background, i16 scanline) {
+    u16 clip_amount;            /* Clip offset */
+    u16 pattern_base;           /* Base pattern table */
 
     /* The base pattern table is 0x0000 if BG_PTRN_TABLE = 0, 
      * 0x1000 otherwise. */
@@ -95,127 +378,11 @@ static void Render_Background(u16 *background) {
     /* If CLIP_BG is set in PPUMASK, the left-most 8 pixels are not
      * rendered. */
     clip_amount = IS_SET(ppu.mask, CLIP_BG) ? 0 : 8;
-    
-    
-    for (i = 0; i < 264; i++) {
-        /* Check to see if the pixel should be rendered. This means
-         * that it is within clip_amount and 256, and that it has a lower
-         * two bits that are non-zero. The first of those conditions can
-         * be checked here.  We don't do this restriction in the loop
-         * condition, because we still need to update registers after
-         * each iteration. */
-        if (i < clip_amount) goto update;
-        
-        /* Calculate the name table index (nt_index).
-         * The name table index calculated here is simply used to select
-         * the correct name table (0, 1, 2, or 3) from memory.  Conveniently
-         * enough, There's a correlation:  
-         * 
-         *      0x2000 -> 0x23FF = name table 0
-         *      0x2400 -> 0x27FF = name table 1
-         *      0x2800 -> 0x2BFF = name table 2
-         *      0x2C00 -> 0x2FFF = name table 3
-         * 
-         * In case it isn't clear, bits 10 and 11 of the address provide
-         * the name table index. Hence, the shift 10 bits followed by
-         * a logical AND 0x03. */
-        //if (0 == ((ppu.v_addr >> 10) & 3)) ppu.v_addr |= 0x2000;
-        nt_index = (ppu.v_addr >> 10) & 0x0003;
-
-        /* Calculate the tile number.
-         * Each tile of the NES's display is stored in a name table as
-         * an index into the pattern table.  The name table map (ppu.nt_map)
-         * is used to account for name table mirroring.  From there, we
-         * can use the least significant 10 bits to get the offset of the
-         * tile we are rendering. */
-        tile_no = ppu.nt_map[nt_index][ppu.v_addr & 0x03FF];
-        
-        /* Calculate the pattern's offset.
-         * Since pattern entries are 16 bytes in size, we shift the 
-         * tile_number left by 4 to arrive at the correct pattern entry.
-         * Lastly, we need to calculate which row of the pattern table
-         * we're going to be rendering on this scanline, which is handled
-         * by the PPUSCROLL's y value. */
-        pattern_offset = pattern_base + (tile_no << 4) + ppu.scrolly;
-        
-        /* Calculate the current attribute table entry 
-         * The attribute table stores the 2 high bits of the palette index.
-         * Attribute table entries start at 0x03C0 from the name table's
-         * beginning.  Attribute table entires represent a 32x32 pixel
-         * area, which means there are 256 / 32 = 8 bytes per row.  The 
-         * x component of the PPU address (5 bits) is a multiple of 8 in
-         * terms of x-coordinate pixels, and with 32 pixels per entry, 
-         * you can just shift the five least significant bits two to the
-         * right: 
-         * 
-         *         x = (ppu.v_addr & 0x001F) >> 2
-         * 
-         * For the y component, which also is in multiples of 8,
-         * needs to be divided by 4, to get the y index, then multiplied by
-         * 8 to skip to the right "row", as this is a one-dimensional array.
-         * The net is a shift left of 1, while disregarding the two least
-         * significant bits of y. Here's an example:
-         * 
-         *         (0b11111 >> 2) << 1 = 0b00111 << 1 = 0b01110 
-         * 
-         * The end result?  We first only grab the 3 most significant bits
-         * of y, to account for a divide by 4.  We have a total of a shift
-         * right 5 to get the bits from the address, followed by a shift
-         * left 1 to account for the divide by 4, then multiply by 8. 
-         * Therefore, the formula is:
-         * 
-         *         y = (ppu.v_addr & 0x0380) >> 4
-         * */
-                                                        /* Y component */            /* X component */
-        current_attr = ppu.nt_map[nt_index][0x03C0 + ((ppu.v_addr & 0x0380) >> 4) + ((ppu.v_addr & 0x001F) >> 2)];
-        /* Once we acquire the attribute table entry, we need to grab the
-         * two bits that are relevant to the 16x16 area we are in.  This can
-         * be achieved by looking at the second bit of the x and y components
-         * of the PPU address; The second bit of x is the second bit of the
-         * PPU address, so an AND of 0x0002 will obtain that bit.  The y
-         * bit requires an and of 0byyy[y]yxxxxx = 0x0040.  We need to
-         * shift that one 4 bits.  Since we are looking at 4 quadrants
-         * with 8 bits of data, we effectively shift by a multiple of 2
-         * of the combined bits, which is why the x bit isn't shifted right
-         * 1.  Finally, we AND with 0x03 to only obtain the two bits of the
-         * byte that we want. */
-                             /* Y component */            /* X component */
-        current_attr >>= ((ppu.v_addr & 0x0040) >> 4) | (ppu.v_addr & 0x0002);
-        current_attr &= 0x03;
-         
-        /* The two low bits are calculated from the pattern table itself. This
-         * is where the precision from scrollx and scrolly help. */
-        current_pixel = ((Read_Cartridge_Chr(pattern_offset) >> (7 - ppu.scrollx)) & 1)
-                       | (((Read_Cartridge_Chr(pattern_offset + 8) >> (7 - ppu.scrollx)) & 1) << 1)
-                       | (current_attr << 2);
-        
-        /* Check that the lower two bits are set.  If they are, we can
-         * render this pixel to the background line. */
-        if (current_pixel & 0x03) {
-            background[i] = current_pixel | 0x3F00;
-        }
-update:
-        /* Update the x scroll position and the PPU address.  Every 8
-         * pixels, we have to increment the PPU address, so we check
-         * the x component of PPUSCROLL */
-        ppu.scrollx++;
-        if (8 == ppu.scrollx) {
-            ppu.scrollx = 0;
-            /* Reconstruct the address to account for new shifts in value:
-             * Every 32 bytes, we change name tables; this is achieved
-             * by checking, pre-increment, for all x bits to be set to 1,
-             * which is 0b11111 = 0x1F = 31.  We flip bit 10, using EOR
-             * of 0x0400.  We then reconstruct the new address, using
-             * the upper 10 bits and the lower 5, incremented. */
-            if ((ppu.v_addr & 0x001F) == 0x001F) {
-                ppu.v_addr &= ~0x001F;
-                ppu.v_addr ^= 0x0400;
-            } else {
-                ppu.v_addr++;
-            }
-        }
+
+    if (!Render_Plane(background, pattern_base, clip_amount, scanline)) {
+        Render_Tiles(background, pattern_base, clip_amount);
     }
-    
+
     /* Dot 256 increments the scanline */
     /* Update the y scroll position and the PPU address, as a result.
      * Every 8 lines, we have to increment to a new y component for
@@ -242,15 +409,95 @@ update:
 
 }
 
-static void Composite_Scanline(i16 scanline, u16 *background, u16 *spr_back, u16 *spr_front) {
+/* Render_Sprites renders the sprites on a scanline into spr_front and
+ * spr_back, by their priority bit.  Sprites earlier in OAM win a pixel
+ * whichever buffer it ends up in, so a bitmask of the pixels already
+ * taken decides which of a sprite's opaque pixels it draws.  Sprite 0
+ * hit is checked against the background line. */
+static void Render_Sprites(i16 scanline, const ppu_sprite_line *sprites,
+                           const u16 *background, u16 *spr_front, u16 *spr_back) {
+    u8 taken[256 / 8 + 1];      /* Bit x & 7 of byte x >> 3: pixel x */
+    const u8 *sprite, *row;
+    const chr_tile *tile;
+    u16 pattern_base, addr, high, *out;
+    u16 x, window;
+    u8 i, k, height, line, mask, hit_from;
+
+    bzero(taken, sizeof(taken));
+    height = IS_SET(ppu.ctrl, SPRITE_SIZE) ? 16 : 8;
+    pattern_base = IS_SET(ppu.ctrl, SPRITE_PTRN_TABLE) ? 0x1000 : 0x0000;
+
+    /* No hit in the left 8 pixels if either layer is clipped there */
+    hit_from = ((CLIP_BG | CLIP_SPRITES) == (ppu.mask & (CLIP_BG | CLIP_SPRITES))) ? 0 : 8;
+
+    for (i = 0; i < sprites->count; i++) {
+        sprite = ppu.oam + sprites->oam[i];
+        line = scanline - 1 - sprite[0];
+        if (sprite[2] & 0x80) line = height - 1 - line;    /* Flip vertically */
+
+        /* 8x16 sprites take their pattern table from bit 0 of the tile
+         * number, and the bottom half from the next tile */
+        if (16 == height) {
+            addr = ((sprite[1] & 0x01) << 12) | ((sprite[1] & 0xFE) << 4);
+            if (line & 0x08) addr += CHR_TILE_BYTES;
+        } else {
+            addr = pattern_base | (sprite[1] << 4);
+        }
+        tile = Ppu_Tile(addr);
+        row = (sprite[2] & 0x40) ? tile->flipped[line & 0x07] : tile->pixel[line & 0x07];
+        mask = Opaque_Mask(row);
+
+        x = sprite[3];
+        if (x > 248) mask &= 0xFF >> (x - 248);
+
+        /* Sprite 0 hits where it's opaque over the background, except
+         * at x = 255 */
+        if (!i && (sprites->flags & SPRITE_LINE_ZERO) &&
+            !IS_SET(ppu.status, SPRITE0_HIT)) {
+            for (k = 0; k < 8; k++) {
+                if ((mask & (1 << k)) && background[x + k] &&
+                    x + k >= hit_from && x + k != 255) {
+                    FLAG_SET(ppu.status, SPRITE0_HIT);
+                    break;
+                }
+            }
+        }
+
+        /* Only the pixels no earlier sprite has taken */
+        window = taken[x >> 3] | (taken[(x >> 3) + 1] << 8);
+        mask &= ~(window >> (x & 0x07));
+        if (!mask) continue;
+        window = mask << (x & 0x07);
+        taken[x >> 3] |= window & 0xFF;
+        taken[(x >> 3) + 1] |= window >> 8;
+
+        out = (sprite[2] & 0x20) ? spr_back : spr_front;
+        high = 0x3F10 | ((sprite[2] & 0x03) << 2);
+        for (k = 0; k < 8; k++) {
+            if (mask & (1 << k)) out[x + k] = high | row[k];
+        }
+    }
+
+    /* If CLIP_SPRITES is clear in PPUMASK, the left-most 8 pixels show
+     * no sprites. */
+    if (!IS_SET(ppu.mask, CLIP_SPRITES)) {
+        bzero(spr_front, 8 * sizeof(u16));
+        bzero(spr_back, 8 * sizeof(u16));
+    }
+}
+
+/* Composite_Scanline picks each pixel's color: a front sprite, then the
+ * background, then a back sprite, then the backdrop. */
+static void Composite_Scanline(i16 scanline, u16 *background, u16 *spr_front, u16 *spr_back) {
     u16 i;
-    u8 color_index = 0;
-    //char buf[256];
-    /* For now, only the background gets drawn. */
+    u8 color;
+
     for (i = 0; i < 256; i++) {
-        //buf[i] = (background[i]) ? '0' + background[i] : ' ';
-        if (4 != (background[i] & 0x0007)) color_index = background[i] & 0x000F;
-        render_data[(scanline * NES_RES_X) + i] = nes_palette[ppu.bg_pal[color_index]];
+        if (spr_front[i]) color = ppu.spr_pal[spr_front[i] & 0x000F];
+        else if (background[i]) color = ppu.bg_pal[background[i] & 0x000F];
+        else if (spr_back[i]) color = ppu.spr_pal[spr_back[i] & 0x000F];
+        else color = ppu.bg_pal[0];
+        render_data[(scanline * NES_RES_X) + i] = nes_palette[color];
     }
 }
 
@@ -280,14 +527,12 @@ void Dump_Pattern_Tables(void) {
         for (i = 0; i < 16; i++) {
             for (y = 0; y < 8; y++) {
                 for (j = 0; j < 16; j++) {
-                    /* Get the pattern data for this particular line. */
-                    u8 t1 = Read_Cartridge_Chr((base * 0x1000) + (i * 0x100) + (j * 0x10) + y);
-                    u8 t2 = Read_Cartridge_Chr((base * 0x1000) + (i * 0x100) + (j * 0x10) + 8 + y);
+                    /* Get the decoded tile for this particular line. */
+                    const chr_tile *tile = Ppu_Tile((base * 0x1000) + (i * 0x100) + (j * 0x10));
                     
-                    /* Composite the pattern data, bit by bit */
-                    for (x = 7; x > -1; x--) {
-                        u8 index = (t1 >> (x) & 1) | (((t2 >> x) & 1) << 1);
-                        fwrite(pt_palette + index, sizeof(u32), 1, stdout);
+                    /* Write out the row, pixel by pixel */
+                    for (x = 0; x < 8; x++) {
+                        fwrite(pt_palette + tile->pixel[y][x], sizeof(u32), 1, stdout);
                     }
                 }
             }
@@ -303,7 +548,7 @@ void Dump_Name_Tables(void) {
         fprintf(fp, "[Name table %u]\n", index);
         for (y = 0; y < 240; y++) {
             for (x = 0; x < 256; x++) {
-                fprintf(fp, "%03u ", ppu.nt_map[index][((y / 8) * 32) + (x / 8)]);
+                fprintf(fp, "%03u ", ppu.page[PPU_NT_PAGE + index][((y / 8) * 32) + (x / 8)]);
             }
             fprintf(fp, "\n");
         }
@@ -320,7 +565,7 @@ void Dump_Attr_Tables(void) {
         for (y = 0; y < 8; y++) {
             fprintf(fp, "\t");
             for (x = 0; x < 8; x++) {
-                fprintf(fp, "%03x ", ppu.nt_map[index][0x3C0 + (y * 8) + x]);
+                fprintf(fp, "%03x ", ppu.page[PPU_NT_PAGE + index][0x3C0 + (y * 8) + x]);
             }
             fprintf(fp, "\n");
         }
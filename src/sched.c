@@ -0,0 +1,79 @@
+/*
+ * Project: VNES
+ * Author: agent
+ * Created: 17-Oct-2026
+ * File: sched.c
+ *
+ * Description:
+ *
+ *      Event scheduler (see sched.h).  There are only a handful of
+ *      events, so the queue is a table indexed by event, searched in
+ *      full whenever it changes.
+ *
+ * Change Log:
+ *      17-Oct-2026:
+ *          File created.
+ */
+
+#include "sched.h"
+
+typedef struct sched_event {
+    u64 at;
+    void (*fire)(void);     /* 0 if not scheduled */
+} sched_event;
+
+static sched_event events[SCHED_EVENTS];
+
+u64 sched_next;
+
+/* Index of the event due first, or SCHED_EVENTS if there is none */
+static u8 First_Event(void) {
+    register u8 i, first = SCHED_EVENTS;
+
+    for (i = 0; i < SCHED_EVENTS; i++) {
+        if (events[i].fire &&
+            (SCHED_EVENTS == first || events[i].at < events[first].at)) {
+            first = i;
+        }
+    }
+    return first;
+}
+
+static void Update_Next(void) {
+    register u8 first = First_Event();
+    sched_next = (SCHED_EVENTS == first) ? SCHED_NEVER : events[first].at;
+}
+
+/* Func: void Sched_Set(u8 event, u64 at, void (*fire)(void))
+ * Desc: Schedules event to fire at the given cycle count, replacing
+ *       any time it was due at before. */
+void Sched_Set(u8 event, u64 at, void (*fire)(void)) {
+    events[event].at = at;
+    events[event].fire = fire;
+    Update_Next();
+}
+
+/* Func: void Sched_Cancel(u8 event)
+ * Desc: Unschedules event, if it was scheduled. */
+void Sched_Cancel(u8 event) {
+    events[event].fire = 0;
+    Update_Next();
+}
+
+/* Func: void Sched_Run(u64 now)
+ * Desc: Fires every event due at or before now, earliest first.  Each
+ *       is unscheduled before it fires, so it may schedule itself
+ *       again (or other events, which also fire if already due). */
+void Sched_Run(u64 now) {
+    register u8 first;
+    void (*fire)(void);
+
+    for (;;) {
+        first = First_Event();
+        if (SCHED_EVENTS == first || events[first].at > now) break;
+        fire = events[first].fire;
+        events[first].fire = 0;
+        fire();
+    }
+    Update_Next();
+}
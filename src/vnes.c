@@ -31,8 +31,16 @@ void VNES_Init(void) {
 }
 
 int main(int argc, char **argv) {
+    int i;
     Load_Cartridge(argv[1]);
     VNES_Init();
+    for (i = 2; i < argc; i++) {
+        if (0 == strcmp(argv[i], "--jit")) {
+            Cpu_Set_Jit(1);
+        } else if (0 == strcmp(argv[i], "--aot") && i + 1 < argc) {
+            Cpu_Load_Aot(argv[++i]);
+        }
+    }
     Start_Debug(0);
     return 0;
 }
@@ -58,6 +66,7 @@ int main(int argc, char **argv) {
 			VNES_Init();
 			cpu.pc = 0xC000;
             ppu.scanline = 241;
+            Ppu_Resync();
 		} else {
 			Load_Cartridge(argv[1]);
             if ((argc > 2) && 0 == strcmp(argv[2], "--ptdump")) {